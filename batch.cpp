@@ -0,0 +1,352 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "batch.h"
+#include "memorystats.h"
+#include "scheduler.h"
+#include "sceneloader.h"
+#include "sheep.h"
+#include <QDir>
+#include <QFile>
+#include <cstdio>
+
+#define DEFAULT_SECONDS 300.  // simulated time per scene
+#define DEFAULT_TICK    16    // simulation tick (ms)
+#define CHECK_TICKS     120   // ticks simulated after a snapshot check
+
+// -------------------------------------------------------------------------
+// SceneJob : simulate one scene for a given time
+// -------------------------------------------------------------------------
+
+class SceneJob : public Job
+{
+ public:
+  SceneJob(Scene* i_scene, double i_seconds, int i_tick_ms)
+    :mp_scene(i_scene), m_seconds(i_seconds), m_tick_ms(i_tick_ms) {}
+
+  virtual void run()
+  {
+    int ticks = (int)((m_seconds * 1000.) / m_tick_ms);
+    for (int i = 0; i < ticks; i++)
+      mp_scene->tick(m_tick_ms);
+  }
+
+ private:
+  Scene* mp_scene;
+  double m_seconds;
+  int    m_tick_ms;
+};
+
+Batch::Batch()
+  :m_params(),
+   m_seconds(DEFAULT_SECONDS),
+   m_tick_ms(DEFAULT_TICK),
+   m_workers(0),
+   m_output(),
+   m_scene(),
+   m_load(),
+   m_snapshot(),
+   m_check(false),
+   m_overrides(0),
+   m_seed(0),
+   m_valid(true)
+{
+}
+
+Batch::~Batch()
+{
+}
+
+// -------------------------------------------------------------------------
+// parseArguments(args) : read batch options (see batch.h)
+//
+// notes : every combination of the parameter values is simulated with
+//         N different seeds
+// return value : 'false' if no batch simulation was asked for
+// -------------------------------------------------------------------------
+
+bool Batch::parseArguments(const QStringList& i_args)
+{
+  bool batch = false;
+  int  count = 0;
+  SceneParameters defaults;
+  vec_values sheep (1, defaults.maximumSheep);
+  vec_values grass (1, defaults.limitGrass);
+  vec_values accel (1, defaults.bigBallAccel);
+
+  for (int i = 1; i < i_args.size(); i++) {
+    const QString& arg = i_args.at(i);
+    QString value = (i + 1 < i_args.size()) ? i_args.at(i + 1) : QString();
+    bool ok = true;
+
+    if      (arg == "--batch")   { batch = true; count = value.toInt(&ok); }
+    else if (arg == "--seconds")   m_seconds = value.toDouble(&ok);
+    else if (arg == "--tick")      m_tick_ms = value.toInt(&ok);
+    else if (arg == "--threads")   m_workers = value.toInt(&ok);
+    else if (arg == "--seed")      defaults.seed = value.toULongLong(&ok);
+    else if (arg == "--output")    m_output = value;
+    else if (arg == "--scene")     m_scene  = value;
+    else if (arg == "--load")      m_load   = value;
+    else if (arg == "--snapshot")  m_snapshot = value;
+    else if (arg == "--check-snapshot") { m_check = true; continue; }
+    else if (arg == "--maximum-sheep")  ok = parseValues(value, sheep);
+    else if (arg == "--limit-grass")    ok = parseValues(value, grass);
+    else if (arg == "--big-ball-accel") ok = parseValues(value, accel);
+    else continue; // not a batch option (may be a Qt option)
+
+    if      (arg == "--seed")           m_overrides |= SEED;
+    else if (arg == "--maximum-sheep")  m_overrides |= MAXIMUM_SHEEP;
+    else if (arg == "--limit-grass")    m_overrides |= LIMIT_GRASS;
+    else if (arg == "--big-ball-accel") m_overrides |= BIG_BALL_ACCEL;
+
+    // the option value has been used
+    i++;
+    if (!ok) m_valid = false;
+  }
+  m_seed = defaults.seed;
+  if (!batch) return false;
+  if ((count <= 0) || (m_seconds <= 0.) || (m_tick_ms <= 0))
+    m_valid = false;
+  if (!m_scene.isEmpty() && !m_load.isEmpty())
+    m_valid = false;
+
+  // one scene per seed and per combination of parameter values
+  m_params.clear();
+  for (unsigned int a = 0; a < sheep.size(); a++)
+    for (unsigned int b = 0; b < grass.size(); b++)
+      for (unsigned int c = 0; c < accel.size(); c++)
+        for (int n = 0; n < count; n++) {
+          SceneParameters p = defaults;
+          p.seed         = defaults.seed + n;
+          p.maximumSheep = (int)sheep[a];
+          p.limitGrass   = grass[b];
+          p.bigBallAccel = accel[c];
+          m_params.push_back(p);
+        }
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// run() : simulate all the scenes and write the results
+//
+// notes : scenes are built and destroyed by the calling thread, since
+//         their textures are Qt pixmaps. only the simulation is threaded,
+//         it may add and remove sheep : the wool texture is kept alive
+//         (and packed in each scene atlas) while the scenes exist.
+// -------------------------------------------------------------------------
+
+int Batch::run()
+{
+  if (!m_valid) {
+    fprintf(stderr, "usage : --batch N [--seconds S] [--tick MS] "
+            "[--threads T] [--seed S] [--maximum-sheep L] "
+            "[--limit-grass L] [--big-ball-accel L] [--output FILE] "
+            "[--scene FILE | --load FILE] [--snapshot FILE] "
+            "[--check-snapshot]\n");
+    return 1;
+  }
+
+  Sheep::retainWool();
+  std::vector<Scene*> scenes;
+  std::vector<SceneJob*> jobs;
+  bool ok = true;
+  for (unsigned int i = 0; ok && (i < m_params.size()); i++) {
+    scenes.push_back(new Scene(m_params[i]));
+    jobs.push_back(new SceneJob(scenes.back(), m_seconds, m_tick_ms));
+    ok = buildScene(i, *scenes.back());
+  }
+
+  if (ok) {
+    Scheduler scheduler(m_workers);
+    for (unsigned int i = 0; i < jobs.size(); i++)
+      scheduler.submit(jobs[i]);
+    scheduler.wait();
+  }
+
+  if (ok) writeResults(scenes);
+  if (ok && !m_snapshot.isEmpty()) ok = saveSnapshots(scenes);
+  for (unsigned int i = 0; ok && m_check && (i < scenes.size()); i++)
+    ok = checkSnapshot(i, *scenes[i]);
+
+  for (unsigned int i = 0; i < scenes.size(); i++) {
+    delete jobs[i];   jobs[i]   = 0;
+    delete scenes[i]; scenes[i] = 0;
+  }
+  Sheep::releaseWool();
+
+  // with all the scenes gone, whatever is still alive has leaked (the
+  // registered materials are kept for the whole process)
+  fprintf(stderr, "memory : %s\n",
+          MemoryStats::current().toString().toLocal8Bit().constData());
+  return (ok ? 0 : 1);
+}
+
+// -------------------------------------------------------------------------
+// buildScene(index, scene) : load the scene file or the snapshot (if any)
+//                            into a scene
+//
+// notes : the tunables given on the command line override the file ones.
+//         setting the parameters restarts the random sequence, so it is
+//         left alone when a snapshot is resumed as it was saved.
+// return value : false -> the scene file can't be loaded
+// -------------------------------------------------------------------------
+
+bool Batch::buildScene(unsigned int i_index, Scene& o_scene) const
+{
+  if (m_scene.isEmpty() && m_load.isEmpty()) return true;
+
+  if (!m_load.isEmpty()) {
+    if (!o_scene.loadSnapshot(m_load)) {
+      fprintf(stderr, "%s : not a valid snapshot\n",
+              m_load.toLocal8Bit().constData());
+      return false;
+    }
+  }
+  else {
+    SceneLoader loader;
+    if (!loader.load(m_scene, o_scene)) {
+      fprintf(stderr, "%s : %s\n", m_scene.toLocal8Bit().constData(),
+              loader.errorString().toLocal8Bit().constData());
+      return false;
+    }
+  }
+
+  const SceneParameters& given = m_params[i_index];
+  SceneParameters p = o_scene.parameters();
+  if (m_overrides & SEED)           p.seed = given.seed;
+  else                              p.seed += given.seed - m_seed;
+  if (m_overrides & MAXIMUM_SHEEP)  p.maximumSheep = given.maximumSheep;
+  if (m_overrides & LIMIT_GRASS)    p.limitGrass   = given.limitGrass;
+  if (m_overrides & BIG_BALL_ACCEL) p.bigBallAccel = given.bigBallAccel;
+  if (m_load.isEmpty() || m_overrides ||
+      (p.seed != o_scene.parameters().seed))
+    o_scene.setParameters(p);
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// checkSnapshot(index, scene) : save a simulated scene and load it into a
+//                               new scene, then make sure both go on the
+//                               same way
+//
+// notes : both scenes are simulated a few more ticks, their snapshots
+//         must then be identical byte for byte. the copy is built by the
+//         calling thread, like the other scenes.
+// return value : false -> the copy diverged (or a snapshot failed)
+// -------------------------------------------------------------------------
+
+bool Batch::checkSnapshot(unsigned int i_index, Scene& io_scene) const
+{
+  QDir temp(QDir::tempPath());
+  QString name  = QString("shaolin_check_%1").arg((int)i_index);
+  QString saved = temp.filePath(name + ".snap");
+  QString fileA = temp.filePath(name + "_a.snap");
+  QString fileB = temp.filePath(name + "_b.snap");
+
+  Scene copy(m_params[i_index]);
+  bool ok = buildScene(i_index, copy) && io_scene.saveSnapshot(saved) &&
+            copy.loadSnapshot(saved);
+  for (int t = 0; ok && (t < CHECK_TICKS); t++) {
+    io_scene.tick(m_tick_ms);
+    copy.tick(m_tick_ms);
+  }
+  ok = ok && io_scene.saveSnapshot(fileA) && copy.saveSnapshot(fileB);
+
+  if (ok) {
+    QFile a(fileA), b(fileB);
+    ok = a.open(QIODevice::ReadOnly) && b.open(QIODevice::ReadOnly) &&
+         (a.readAll() == b.readAll());
+  }
+  QFile::remove(saved);
+  QFile::remove(fileA);
+  QFile::remove(fileB);
+
+  if (!ok)
+    fprintf(stderr, "scene %u : the reloaded snapshot diverged\n", i_index);
+  return ok;
+}
+
+// -------------------------------------------------------------------------
+// saveSnapshots(scenes) : save each scene (--snapshot FILE)
+//
+// notes : FILE.index is used when there are several scenes
+// return value : false -> a snapshot can't be written
+// -------------------------------------------------------------------------
+
+bool Batch::saveSnapshots(const std::vector<Scene*>& i_scenes) const
+{
+  for (unsigned int i = 0; i < i_scenes.size(); i++) {
+    QString file = m_snapshot;
+    if (i_scenes.size() > 1) file += QString(".%1").arg((int)i);
+    if (!i_scenes[i]->saveSnapshot(file)) {
+      fprintf(stderr, "can't write %s\n", file.toLocal8Bit().constData());
+      return false;
+    }
+  }
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// parseValues(text, values) : read comma separated values
+// -------------------------------------------------------------------------
+
+bool Batch::parseValues(const QString& i_text, vec_values& o_values)
+{
+  QStringList list = i_text.split(",");
+  vec_values values;
+  for (int i = 0; i < list.size(); i++) {
+    bool ok = false;
+    values.push_back(list.at(i).toDouble(&ok));
+    if (!ok) return false;
+  }
+  if (values.empty()) return false;
+  o_values.swap(values);
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// writeResults(scenes) : one csv line per scene
+// -------------------------------------------------------------------------
+
+void Batch::writeResults(const std::vector<Scene*>& i_scenes) const
+{
+  FILE* f = stdout;
+  if (!m_output.isEmpty()) {
+    f = fopen(m_output.toLocal8Bit().constData(), "w");
+    if (!f) {
+      fprintf(stderr, "can't write %s\n", m_output.toLocal8Bit().constData());
+      return;
+    }
+  }
+
+  fprintf(f, "scene,seed,maximum_sheep,limit_grass,big_ball_accel,"
+          "seconds,sheep,collisions,victims_hit,time_survived\n");
+  for (unsigned int i = 0; i < i_scenes.size(); i++) {
+    const SceneParameters& p = i_scenes[i]->parameters();
+    const SceneStats&      s = i_scenes[i]->stats();
+    fprintf(f, "%u,%llu,%d,%g,%g,%.3f,%d,%d,%d,%.3f\n",
+            i, (unsigned long long)p.seed, p.maximumSheep, p.limitGrass,
+            p.bigBallAccel, s.seconds, s.sheep, s.collisions,
+            s.victimsHit, s.timeSurvived);
+  }
+
+  if (f != stdout) fclose(f);
+}
@@ -0,0 +1,101 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+class   Batch;
+
+#include "scene.h"
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class Batch
+//
+// Batch : simulate many independent scenes without any window, using
+//         a pool of threads, and report herd survival metrics for each
+//         scene as csv
+//
+//   --batch N            scenes (seeds) for each set of parameters
+//   --seconds S          simulated time per scene           (300)
+//   --tick MS            simulation tick                    (16)
+//   --threads T          worker threads      (one per processor)
+//   --seed S             seed of the first scene            (42)
+//   --maximum-sheep L    comma separated values to try
+//   --limit-grass L      comma separated values to try
+//   --big-ball-accel L   comma separated values to try
+//   --output FILE        csv file                  (standard output)
+//   --scene FILE         scene description file (see SceneLoader)
+//   --load FILE          start from a snapshot (see Scene::saveSnapshot)
+//   --snapshot FILE      save the scenes once simulated     (FILE.index
+//                        when there are several scenes)
+//   --check-snapshot     save and reload each simulated scene, and make
+//                        sure both copies go on identically
+//
+//   with --scene or --load, the file tunables are used unless they are
+//   given on the command line, and N seeds are simulated from the file
+//   seed. a loaded scene resumes its random sequence, unless its seed or
+//   its tunables are changed
+//
+{
+ public:
+  Batch();
+  ~Batch();
+
+  // read batch options, 'false' if no batch simulation was asked for
+  bool parseArguments(const QStringList& i_args);
+
+  // simulate all the scenes (return value : process exit code)
+  int run();
+
+ private:
+  typedef std::vector<SceneParameters> vec_params;
+  typedef std::vector<double>          vec_values;
+
+  // options given on the command line (override the scene file)
+  enum Overrides {
+    SEED           = 1,
+    MAXIMUM_SHEEP  = 2,
+    LIMIT_GRASS    = 4,
+    BIG_BALL_ACCEL = 8
+  };
+
+  static bool parseValues(const QString& i_text, vec_values& o_values);
+  bool buildScene(unsigned int i_index, Scene& o_scene) const;
+  bool checkSnapshot(unsigned int i_index, Scene& io_scene) const;
+  bool saveSnapshots(const std::vector<Scene*>& i_scenes) const;
+  void writeResults(const std::vector<Scene*>& i_scenes) const;
+
+  vec_params m_params;   // one entry per scene to simulate
+  double     m_seconds;  // simulated time per scene
+  int        m_tick_ms;  // simulation tick
+  int        m_workers;  // worker threads (0 -> one per processor)
+  QString    m_output;   // csv file (empty -> standard output)
+  QString    m_scene;    // scene description file (empty -> default)
+  QString    m_load;     // snapshot to start from (empty -> none)
+  QString    m_snapshot; // snapshot to save (empty -> none)
+  bool       m_check;    // check each scene snapshot?
+  int        m_overrides;// Overrides flags
+  quint64    m_seed;     // seed of the first scene
+  bool       m_valid;    // were the arguments understood?
+};
+
+#endif // BATCH_H
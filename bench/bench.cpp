@@ -0,0 +1,487 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "benchmark.h"
+#include "vector.h"
+#include "matrix.h"
+#include "transform.h"
+#include "boundingsphere.h"
+#include "globject.h"
+#include "physics.h"
+#include "contactsolver.h"
+#include "ball.h"
+#include "sheep.h"
+#include "sheepanimator.h"
+#include "spatialgrid.h"
+#include "boundinghierarchy.h"
+#include "ray.h"
+#include "flock.h"
+#include "scheduler.h"
+#include "scene.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <cmath>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Vector
+// -------------------------------------------------------------------------
+
+static void Vector_arithmetic(Benchmark& b)
+{
+  Vector a(1., 2., 3.), v(0.5, -0.25, 0.125);
+  for (int i = 0; i < b.iterations(); i++) {
+    a = (a + v) * 0.5 - (v / 3.);
+    a += v; a *= 1.0001;
+  }
+  Benchmark::doNotOptimize(&a);
+}
+BENCHMARK(Vector_arithmetic);
+
+static void Vector_l2normalize(Benchmark& b)
+{
+  Vector a;
+  for (int i = 0; i < b.iterations(); i++) {
+    a.set(1. + i, 2., 3.);
+    a.l2normalize();
+  }
+  Benchmark::doNotOptimize(&a);
+}
+BENCHMARK(Vector_l2normalize);
+
+// -------------------------------------------------------------------------
+// Matrix, Transform
+// -------------------------------------------------------------------------
+
+static void Matrix_multiply(Benchmark& b)
+{
+  Matrix m(1., 2., 3., 4.,  5., 6., 7., 8.,
+           9., 1., 2., 3.,  4., 5., 6., 7.);
+  Matrix r;
+  for (int i = 0; i < b.iterations(); i++)
+    r = m * r;
+  Benchmark::doNotOptimize(&r);
+}
+BENCHMARK(Matrix_multiply);
+
+static void Transform_addRotation(Benchmark& b)
+{
+  Transform t;
+  Vector axis(0.3, 1., 0.2);
+  for (int i = 0; i < b.iterations(); i++)
+    t.addRotation(1.5, axis);
+  Benchmark::doNotOptimize(&t);
+}
+BENCHMARK(Transform_addRotation);
+
+// -------------------------------------------------------------------------
+// BoundingSphere
+// -------------------------------------------------------------------------
+
+static void BoundingSphere_theUnion(Benchmark& b)
+{
+  BoundingSphere s1(1., Vector(0., 0., 0.));
+  BoundingSphere s2(0.5, Vector(1.2, 0.3, -0.4));
+  BoundingSphere r;
+  for (int i = 0; i < b.iterations(); i++)
+    r = s1.theUnion(s2);
+  Benchmark::doNotOptimize(&r);
+}
+BENCHMARK(BoundingSphere_theUnion);
+
+static void BoundingSphere_applyTransform(Benchmark& b)
+{
+  Transform t;
+  t.setTranslation(Vector(1., 2., 3.));
+  t.setScaling(Vector(0.7, 0.7, 1.2));
+  BoundingSphere s(1., Vector(0.1, 0.2, 0.3));
+  BoundingSphere r;
+  for (int i = 0; i < b.iterations(); i++) {
+    r = s;
+    r.applyTransform(t);
+  }
+  Benchmark::doNotOptimize(&r);
+}
+BENCHMARK(BoundingSphere_applyTransform);
+
+static void BoundingSphere_intersects(Benchmark& b)
+{
+  BoundingSphere s1(1., Vector(0., 0., 0.));
+  BoundingSphere s2(0.5, Vector(1.2, 0.3, -0.4));
+  int n = 0;
+  for (int i = 0; i < b.iterations(); i++)
+    if (s1.intersects(s2)) n++;
+  Benchmark::doNotOptimize(&n);
+}
+BENCHMARK(BoundingSphere_intersects);
+
+// -------------------------------------------------------------------------
+// Globject::introduceTo : two colliding balls
+// -------------------------------------------------------------------------
+
+static void Globject_introduceTo(Benchmark& b)
+{
+  Ball a(1.), c(1.);
+  a.setMovable(true);
+  c.setMovable(true);
+  for (int i = 0; i < b.iterations(); i++) {
+    a.setPosition(Vector(0.,  0., 0.));
+    c.setPosition(Vector(1.5, 0., 0.));
+    a.setVelocity(Vector( 1., 0., 0.));
+    c.setVelocity(Vector(-1., 0., 0.));
+    a.introduceTo(c);
+  }
+  Benchmark::doNotOptimize(&a);
+}
+BENCHMARK(Globject_introduceTo);
+
+// -------------------------------------------------------------------------
+// Physics::tick : n balls on the ground of a very large world
+// -------------------------------------------------------------------------
+
+static void ballWorld(Globject& o_world, int i_balls)
+{
+  o_world.setContainerLimits(BoundingSphere(1.e10, Vector(0., 1.e10, 0.)));
+  int side = 1;
+  while (side * side < i_balls) side++;
+  for (int i = 0; i < i_balls; i++) {
+    Ball* ball = new Ball(1.);
+    ball->setMovable(true);
+    ball->setPosition(Vector((i % side) * 2.5, 1., (i / side) * 2.5));
+    ball->setVelocity(Vector(0.1 * (i % 3), 0., 0.1 * (i % 5)));
+    o_world.addChild(ball);
+  }
+}
+
+static void Physics_tick(Benchmark& b)
+{
+  b.pauseTiming();
+  Globject world;
+  ballWorld(world, b.arg());
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++)
+    Physics::tick(0.016, world);
+
+  // the world is destroyed outside of the measure
+  b.pauseTiming();
+}
+BENCHMARK_ARG(Physics_tick, 8);
+BENCHMARK_ARG(Physics_tick, 64);
+BENCHMARK_ARG(Physics_tick, 512);
+
+// -------------------------------------------------------------------------
+// Physics::tick with the contact solver (same balls, 8 iterations)
+// -------------------------------------------------------------------------
+
+static void ContactSolver_tick(Benchmark& b)
+{
+  b.pauseTiming();
+  Globject world;
+  ballWorld(world, b.arg());
+  ContactSolver solver;
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++)
+    Physics::tick(0.016, world, 0, 0, 0, &solver);
+
+  b.pauseTiming();
+}
+BENCHMARK_ARG(ContactSolver_tick, 8);
+BENCHMARK_ARG(ContactSolver_tick, 64);
+BENCHMARK_ARG(ContactSolver_tick, 512);
+
+// -------------------------------------------------------------------------
+// Sheep::setAnimationPhase
+// -------------------------------------------------------------------------
+
+class BenchSheep : public Sheep
+{
+ public:
+  BenchSheep() :Sheep(0.70) {}
+  using Sheep::setAnimationPhase;
+  using Sheep::setDisplacementMode;
+  using Sheep::globject_tick;
+};
+
+static void Sheep_setAnimationPhase(Benchmark& b)
+{
+  b.pauseTiming();
+  Sheep::setShaderAnimation(b.arg() == 2);
+  BenchSheep sheep;
+  sheep.setDisplacementMode(b.arg() != 1);
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++)
+    sheep.setAnimationPhase(i * 0.01);
+
+  b.pauseTiming();
+  Sheep::setShaderAnimation(false);
+}
+BENCHMARK_ARG(Sheep_setAnimationPhase, 0); // walking
+BENCHMARK_ARG(Sheep_setAnimationPhase, 1); // running
+BENCHMARK_ARG(Sheep_setAnimationPhase, 2); // walking, shader animation
+
+// -------------------------------------------------------------------------
+// SheepAnimator::update : a new phase for each sheep of a large herd,
+//                         posed one by one (arg 0) or all at once (arg 1),
+//                         on all the processors (arg 2)
+// -------------------------------------------------------------------------
+
+static void SheepAnimator_update(Benchmark& b)
+{
+  static const int HERD = 10000;
+
+  b.pauseTiming();
+  Scheduler scheduler;
+  SheepAnimator animator;
+  if (b.arg() == 2) animator.setScheduler(&scheduler);
+  std::vector<BenchSheep*> herd(HERD);
+  for (int i = 0; i < HERD; i++) {
+    herd[i] = new BenchSheep;
+    herd[i]->setDisplacementMode((i % 3) != 0);
+    if (b.arg() >= 1) herd[i]->setAnimator(&animator);
+  }
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++) {
+    for (int j = 0; j < HERD; j++)
+      herd[j]->setAnimationPhase(i * 0.01 + j * 0.001);
+    animator.update();
+  }
+
+  b.pauseTiming();
+  for (int i = 0; i < HERD; i++) delete herd[i];
+}
+BENCHMARK_ARG(SheepAnimator_update, 0); // Sheep::setAnimationPhase
+BENCHMARK_ARG(SheepAnimator_update, 1); // batched
+BENCHMARK_ARG(SheepAnimator_update, 2); // batched, parallel
+
+// -------------------------------------------------------------------------
+// Sheep::globject_tick : one step of a walking herd, the legs animated
+//                        every 'arg' steps (0 : frozen, hidden sheep)
+// -------------------------------------------------------------------------
+
+static void Sheep_tick(Benchmark& b)
+{
+  static const int HERD = 1000;
+
+  b.pauseTiming();
+  SheepAnimator animator;
+  std::vector<BenchSheep*> herd(HERD);
+  for (int i = 0; i < HERD; i++) {
+    herd[i] = new BenchSheep;
+    herd[i]->setMovable(true);
+    herd[i]->setVelocity(Vector(cos(i * 0.1), 0., sin(i * 0.1)));
+    herd[i]->setAnimator(&animator);
+    herd[i]->setAnimationRate(b.arg());
+  }
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++) {
+    for (int j = 0; j < HERD; j++)
+      herd[j]->globject_tick(1. / 60.);
+    animator.update();
+  }
+
+  b.pauseTiming();
+  for (int i = 0; i < HERD; i++) delete herd[i];
+}
+BENCHMARK_ARG(Sheep_tick, 1); // full rate
+BENCHMARK_ARG(Sheep_tick, 4); // far away
+BENCHMARK_ARG(Sheep_tick, 0); // hidden
+
+// -------------------------------------------------------------------------
+// SpatialGrid::nearest : closest of a large herd to a moving point, by
+//                        looking at each body (arg 0) or in a grid (arg 1)
+// -------------------------------------------------------------------------
+
+static void SpatialGrid_nearest(Benchmark& b)
+{
+  static const int HERD = 10000;
+
+  b.pauseTiming();
+  Globject world;
+  SpatialGrid grid;
+  grid.setLimit(500.);
+  for (int i = 0; i < HERD; i++) {
+    // evenly spread on a disc, as 'herd COUNT disc 45' (see SceneLoader)
+    double r = 45. * sqrt((i + 0.5) / HERD), a = i * 2.39996;
+    Ball* ball = new Ball(0.5);
+    ball->setPosition(Vector(r * cos(a), 0.5, r * sin(a)));
+    world.addChild(ball);
+    grid.insert(ball);
+  }
+  grid.update();
+  SpatialGrid::vec_globject found;
+  b.resumeTiming();
+
+  const Globject::vec_globject& herd = world.children();
+  for (int i = 0; i < b.iterations(); i++) {
+    Vector point(60. * sin(i * 0.1), 0., 60. * cos(i * 0.13));
+    const Globject* closest = 0;
+    if (b.arg() == 0) {
+      double best = 1.e300;
+      for (int j = 0; j < HERD; j++) {
+        double d = (herd[j]->position() - point).l2norm();
+        if (d < best) { best = d; closest = herd[j]; }
+      }
+    }
+    else if (grid.nearest(point, 1, found)) closest = found[0];
+    Benchmark::doNotOptimize(&closest);
+  }
+
+  b.pauseTiming();
+}
+BENCHMARK_ARG(SpatialGrid_nearest, 0); // linear search
+BENCHMARK_ARG(SpatialGrid_nearest, 1); // grid
+
+// -------------------------------------------------------------------------
+// BoundingHierarchy::rayCast : first of a large herd on a ray, by testing
+//   each body (arg 0), in a grid (arg 1) or in the hierarchy (arg 2)
+// -------------------------------------------------------------------------
+
+static void BoundingHierarchy_rayCast(Benchmark& b)
+{
+  static const int HERD = 10000;
+
+  b.pauseTiming();
+  Globject world;
+  for (int i = 0; i < HERD; i++) {
+    double r = 45. * sqrt((i + 0.5) / HERD), a = i * 2.39996;
+    Ball* ball = new Ball(0.5);
+    ball->setPosition(Vector(r * cos(a), 0.5, r * sin(a)));
+    world.addChild(ball);
+  }
+  const Globject::vec_globject& herd = world.children();
+  SpatialGrid grid;
+  grid.setLimit(500.);
+  for (int i = 0; i < HERD; i++) grid.insert(herd[i]);
+  grid.update();
+  BoundingHierarchy hierarchy;
+  hierarchy.update(herd);
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++) {
+    // looking down at the herd from a camera going around it
+    Vector eye(60. * sin(i * 0.1), 20., 60. * cos(i * 0.1));
+    Ray ray(eye, Vector(20. * sin(i * 0.37), 0., 20. * cos(i * 0.41)) - eye);
+    const Globject* hit = 0;
+    if (b.arg() == 0) {
+      double best = 1.e300, t;
+      for (int j = 0; j < HERD; j++)
+        if (ray.intersects(herd[j]->boundingSphere(), &t) && (t < best)) {
+          best = t; hit = herd[j];
+        }
+    }
+    else if (b.arg() == 1) hit = grid.rayCast(ray);
+    else                   hit = hierarchy.rayCast(ray);
+    Benchmark::doNotOptimize(&hit);
+  }
+
+  b.pauseTiming();
+}
+BENCHMARK_ARG(BoundingHierarchy_rayCast, 0); // linear search
+BENCHMARK_ARG(BoundingHierarchy_rayCast, 1); // SpatialGrid::rayCast
+BENCHMARK_ARG(BoundingHierarchy_rayCast, 2); // BoundingHierarchy::rayCast
+
+// -------------------------------------------------------------------------
+// Flock::steer : one step of a herd of n sheep, around 4 Big Red Balls
+// -------------------------------------------------------------------------
+
+static void Flock_steer(Benchmark& b)
+{
+  b.pauseTiming();
+  Globject world;
+  Flock::vec_globject herd, threats;
+  double radius = 45. * sqrt(b.arg() / 10000.);
+  for (int i = 0; i < b.arg(); i++) {
+    double r = radius * sqrt((i + 0.5) / b.arg()), a = i * 2.39996;
+    BenchSheep* sheep = new BenchSheep;
+    sheep->setMovable(true);
+    sheep->setPosition(Vector(r * cos(a), 0., r * sin(a)));
+    sheep->setVelocity(Vector(0.3 * cos(a), 0., 0.3 * sin(a)));
+    world.addChild(sheep);
+    herd.push_back(sheep);
+  }
+  for (int i = 0; i < 4; i++) {
+    Ball* ball = new Ball(2.);
+    double a = i * M_PI / 2.;
+    ball->setPosition(Vector(radius * cos(a), 2., radius * sin(a)));
+    world.addChild(ball);
+    threats.push_back(ball);
+  }
+  Flock flock;
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++)
+    flock.steer(1. / 60., herd, threats);
+
+  b.pauseTiming();
+}
+BENCHMARK_ARG(Flock_steer, 1000);
+BENCHMARK_ARG(Flock_steer, 10000);
+
+// -------------------------------------------------------------------------
+// Scene::loadSnapshot : a herd of n sheep and 4 Big Red Balls
+// -------------------------------------------------------------------------
+
+static void Scene_loadSnapshot(Benchmark& b)
+{
+  b.pauseTiming();
+  QString file = QDir(QDir::tempPath()).filePath("shaolin_bench.snap");
+  {
+    Scene scene;
+    scene.clear();
+    double radius = 45. * sqrt(b.arg() / 10000.);
+    for (int i = 0; i < b.arg(); i++) {
+      double r = radius * sqrt((i + 0.5) / b.arg()), a = i * 2.39996;
+      Sheep* sheep = scene.addSheep(0.5, true);
+      sheep->setPosition(Vector(r * cos(a), 0.2, r * sin(a)));
+      sheep->setVelocity(Vector(0.3 * cos(a), 0., 0.3 * sin(a)));
+    }
+    for (int i = 0; i < 4; i++) {
+      Ball* ball = scene.addBall(2., true);
+      double a = i * M_PI / 2.;
+      ball->setPosition(Vector(radius * cos(a), 2., radius * sin(a)));
+    }
+    scene.tick(16);
+    scene.saveSnapshot(file);
+  }
+  Scene scene;
+  b.resumeTiming();
+
+  for (int i = 0; i < b.iterations(); i++)
+    scene.loadSnapshot(file);
+
+  b.pauseTiming();
+  QFile::remove(file);
+}
+BENCHMARK_ARG(Scene_loadSnapshot, 1000);
+BENCHMARK_ARG(Scene_loadSnapshot, 10000);
+
+int main(int argc, char** argv)
+{
+  // sheep wool is painted on a qt pixmap
+  QApplication app(argc, argv);
+  return Benchmark::main(argc, argv);
+}
@@ -0,0 +1,20 @@
+######################################################################
+# Shaolin Sheep micro-benchmarks
+#
+#   qmake && make && ./shaolin_bench [--filter TEXT] [--json FILE]
+######################################################################
+
+TEMPLATE = app
+TARGET = shaolin_bench
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+QT += opengl
+CONFIG += release console
+
+# Harness
+HEADERS += benchmark.h
+SOURCES += benchmark.cpp bench.cpp
+
+# Code under test
+HEADERS += ball.h texture.h cylinder.h globject.h quadric.h sphere.h disk.h tube.h transform.h vector.h matrix.h sheep.h material.h color.h boundingsphere.h physics.h random.h sheepanimator.h scheduler.h textureatlas.h spatialgrid.h ray.h boundinghierarchy.h flock.h contactsolver.h memorystats.h lightingshader.h materialregistry.h scene.h camera.h snapshot.h terrain.h streambuffer.h worldpager.h
+SOURCES += ball.cpp texture.cpp cylinder.cpp globject.cpp quadric.cpp sphere.cpp disk.cpp tube.cpp transform.cpp vector.cpp matrix.cpp sheep.cpp material.cpp color.cpp boundingsphere.cpp physics.cpp random.cpp sheepanimator.cpp scheduler.cpp textureatlas.cpp spatialgrid.cpp ray.cpp boundinghierarchy.cpp flock.cpp contactsolver.cpp memorystats.cpp lightingshader.cpp materialregistry.cpp scene.cpp camera.cpp snapshot.cpp terrain.cpp streambuffer.cpp worldpager.cpp
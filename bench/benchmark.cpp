@@ -0,0 +1,251 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "benchmark.h"
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#define DEFAULT_MIN_TIME 0.2        // minimum measured time (s)
+#define MAX_ITERATIONS   1000000000 // never run more iterations than that
+
+// -------------------------------------------------------------------------
+// heap allocation counting : every global new goes through here
+//
+// notes : benchmarks may allocate from worker threads (see Scheduler),
+//         the count is atomic. it wraps around, only differences of
+//         counts are used.
+// -------------------------------------------------------------------------
+
+static QAtomicInt s_allocations(0);
+
+static unsigned int allocations()
+{
+  return (unsigned int)(int)s_allocations;
+}
+
+// computed values are stored here to be kept by the compiler
+static const void* volatile s_sink = 0;
+
+void* operator new(std::size_t i_size)
+{
+  s_allocations.fetchAndAddRelaxed(1);
+  void* p = malloc(i_size ? i_size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t i_size)
+{
+  s_allocations.fetchAndAddRelaxed(1);
+  void* p = malloc(i_size ? i_size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) throw()
+{
+  free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+  free(p);
+}
+
+// -------------------------------------------------------------------------
+// now() : nanoseconds elapsed since the first call
+// -------------------------------------------------------------------------
+
+static long long now()
+{
+  static QElapsedTimer timer;
+  if (!timer.isValid()) timer.start();
+  return timer.nsecsElapsed();
+}
+
+Benchmark::Benchmark(const char* i_name, Function i_function, int i_arg)
+  :m_name(i_name),
+   m_function(i_function),
+   m_arg(i_arg),
+   m_iterations(0),
+   m_ns(0.),
+   m_allocs(0.),
+   m_pause_ns(0),
+   m_pause_allocs(0),
+   m_paused_ns(0),
+   m_paused_allocs(0),
+   m_paused(false)
+{
+  if (m_arg >= 0) {
+    char buf[32];
+    sprintf(buf, "/%d", m_arg);
+    m_name += buf;
+  }
+  registry().push_back(this);
+}
+
+int Benchmark::iterations() const
+{
+  return m_iterations;
+}
+
+int Benchmark::arg() const
+{
+  return m_arg;
+}
+
+// -------------------------------------------------------------------------
+// pauseTiming() / resumeTiming() : exclude setup code from the results
+// -------------------------------------------------------------------------
+
+void Benchmark::pauseTiming()
+{
+  if (m_paused) return;
+  m_paused       = true;
+  m_pause_ns     = now();
+  m_pause_allocs = allocations();
+}
+
+void Benchmark::resumeTiming()
+{
+  if (!m_paused) return;
+  m_paused         = false;
+  m_paused_ns     += now() - m_pause_ns;
+  m_paused_allocs += (unsigned int)(allocations() - m_pause_allocs);
+}
+
+void Benchmark::doNotOptimize(const void* p)
+{
+  s_sink = p;
+}
+
+// -------------------------------------------------------------------------
+// run(min_time) : run the benchmark with more and more iterations until
+//                 it lasts at least 'min_time' seconds
+// -------------------------------------------------------------------------
+
+void Benchmark::run(double i_min_time)
+{
+  double min_ns = i_min_time * 1.e9;
+  m_iterations = 1;
+
+  for (;;) {
+    m_paused_ns = 0; m_paused_allocs = 0; m_paused = false;
+    unsigned int start_allocs = allocations();
+    long long    start = now();
+
+    m_function(*this);
+
+    // the function ended paused : its teardown isn't measured
+    resumeTiming();
+
+    long long elapsed = now() - start - m_paused_ns;
+    long long allocs = (unsigned int)(allocations() - start_allocs) -
+                       m_paused_allocs;
+
+    if ((elapsed >= min_ns) || (m_iterations >= MAX_ITERATIONS)) {
+      m_ns     = (double)elapsed / m_iterations;
+      m_allocs = (double)allocs  / m_iterations;
+      return;
+    }
+
+    // guess how many iterations are needed, but grow reasonably
+    double mult = (elapsed > 0) ? (min_ns * 1.4) / elapsed : 10.;
+    if (mult <  2.) mult =  2.;
+    if (mult > 10.) mult = 10.;
+    double next = m_iterations * mult;
+    m_iterations = (next > MAX_ITERATIONS) ? MAX_ITERATIONS : (int)next;
+  }
+}
+
+Benchmark::vec_benchmarks& Benchmark::registry()
+{
+  static vec_benchmarks benchmarks;
+  return benchmarks;
+}
+
+// -------------------------------------------------------------------------
+// main(argc, argv) : run the registered benchmarks (see benchmark.h)
+// -------------------------------------------------------------------------
+
+int Benchmark::main(int argc, char** argv)
+{
+  const char* filter   = 0;
+  const char* json     = 0;
+  double      min_time = DEFAULT_MIN_TIME;
+
+  for (int i = 1; i < argc; i++) {
+    if      (!strcmp(argv[i], "--filter")   && (i+1 < argc)) filter = argv[++i];
+    else if (!strcmp(argv[i], "--json")     && (i+1 < argc)) json   = argv[++i];
+    else if (!strcmp(argv[i], "--min-time") && (i+1 < argc))
+      min_time = atof(argv[++i]);
+  }
+
+  vec_benchmarks done;
+  printf("%-40s %15s %12s %12s\n", "Benchmark", "Iterations", "ns/op",
+         "allocs/op");
+  for (vec_benchmarks::iterator it = registry().begin();
+       it != registry().end(); it++) {
+    Benchmark* b = (*it);
+    if (filter && !strstr(b->m_name.c_str(), filter)) continue;
+
+    b->run(min_time);
+    printf("%-40s %15d %12.1f %12.2f\n", b->m_name.c_str(),
+           b->m_iterations, b->m_ns, b->m_allocs);
+    fflush(stdout);
+    done.push_back(b);
+  }
+
+  if (json) {
+    FILE* f = fopen(json, "w");
+    if (!f) {
+      fprintf(stderr, "can't write %s\n", json);
+      return 1;
+    }
+    fprintf(f, "{\n  \"context\": {\n    \"library_build_type\": \"%s\"\n"
+            "  },\n  \"benchmarks\": [\n",
+#ifdef QT_NO_DEBUG
+            "release"
+#else
+            "debug"
+#endif
+            );
+    for (unsigned int i = 0; i < done.size(); i++) {
+      fprintf(f, "    {\n"
+              "      \"name\": \"%s\",\n"
+              "      \"iterations\": %d,\n"
+              "      \"real_time\": %.3f,\n"
+              "      \"time_unit\": \"ns\",\n"
+              "      \"allocs_per_iter\": %.3f\n"
+              "    }%s\n",
+              done[i]->m_name.c_str(), done[i]->m_iterations,
+              done[i]->m_ns, done[i]->m_allocs,
+              (i + 1 < done.size()) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+class   Benchmark;
+
+#include <string>
+#include <vector>
+
+class Benchmark
+//
+// Benchmark : minimal micro-benchmark harness
+//
+//   - a benchmark function runs its code 'iterations()' times, the
+//     harness increases the number of iterations until the run is long
+//     enough to be measured
+//   - time (ns/op) and heap allocations (allocs/op) are reported
+//   - results can be written as json (google benchmark layout), so that
+//     two runs can be compared
+//
+{
+ public:
+  typedef void (*Function)(Benchmark& b);
+
+  // register a benchmark (see the BENCHMARK macros below)
+  Benchmark(const char* i_name, Function i_function, int i_arg = -1);
+
+  // iterations to run, and optional argument (object count, etc.)
+  int iterations() const;
+  int arg() const;
+
+  // time spent outside of pauseTiming/resumeTiming is not measured
+  // (a pause still open when the benchmark function returns lasts until
+  // it has returned : local objects are destroyed outside of the measure)
+  void pauseTiming();
+  void resumeTiming();
+
+  // prevent the compiler from optimizing away a computed value
+  static void doNotOptimize(const void* p);
+
+  // run the registered benchmarks
+  //   --filter TEXT   only run benchmarks whose name contains TEXT
+  //   --json FILE     also write the results to a json file
+  //   --min-time S    minimum measured time per benchmark (0.2)
+  static int main(int argc, char** argv);
+
+ private:
+  void run(double i_min_time);
+
+  std::string  m_name;          // name reported (with the argument)
+  Function     m_function;      // benchmark function
+  int          m_arg;           // optional argument (-1 if none)
+  int          m_iterations;    // iterations for the current run
+  double       m_ns;            // ns per iteration (result)
+  double       m_allocs;        // allocations per iteration (result)
+  long long    m_pause_ns;      // when the timing was paused (ns)
+  unsigned int m_pause_allocs;  // allocations when the timing was paused
+  long long    m_paused_ns;     // time spent paused during this run
+  long long    m_paused_allocs; // allocations made while paused
+  bool         m_paused;        // is the timing paused?
+
+  typedef std::vector<Benchmark*> vec_benchmarks;
+  static vec_benchmarks& registry();
+};
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b)  BENCHMARK_CONCAT2(a, b)
+
+// register a benchmark function, with an optional argument
+#define BENCHMARK(f) \
+  static Benchmark BENCHMARK_CONCAT(bench_, __LINE__)(#f, f)
+#define BENCHMARK_ARG(f, a) \
+  static Benchmark BENCHMARK_CONCAT(bench_, __LINE__)(#f, f, a)
+
+#endif // BENCHMARK_H
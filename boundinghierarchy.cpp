@@ -0,0 +1,249 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "boundinghierarchy.h"
+#include "globject.h"
+#include "ray.h"
+#include "scheduler.h"
+#include <algorithm>
+
+#define LEAF_SIZE      4      // globjects in a leaf, at most
+#define REBUILD_REFITS 256    // refits before the tree is built again
+#define STACK_SIZE     64     // deepest tree that can be searched
+#define FAR_AWAY       1.e300 // no hit yet
+#define ITEMS_PER_JOB  256    // fewer spheres to read are not worth a job
+
+// -------------------------------------------------------------------------
+// ByAxis : order items by the position of their center along an axis
+// -------------------------------------------------------------------------
+
+struct BoundingHierarchy::ByAxis
+{
+  ByAxis(int i_axis) :axis(i_axis) {}
+  bool operator()(const Item& a, const Item& b) const
+  {
+    return (a.sphere.center()[axis] < b.sphere.center()[axis]);
+  }
+  int axis;
+};
+
+// -------------------------------------------------------------------------
+// Spheres : read the bounding spheres of a range of items
+// -------------------------------------------------------------------------
+
+class BoundingHierarchy::Spheres : public Loop
+{
+ public:
+  Spheres(vec_items& io_items) :Loop(), m_items(io_items) {}
+
+  virtual void run(int i_begin, int i_end)
+  {
+    for (int i = i_begin; i < i_end; i++)
+      m_items[i].sphere = m_items[i].object->boundingSphere();
+  }
+
+ private:
+  vec_items& m_items;
+};
+
+BoundingHierarchy::BoundingHierarchy()
+  :m_objects(),
+   m_items(),
+   m_nodes(),
+   m_refits(0)
+{
+}
+
+// -------------------------------------------------------------------------
+// update(globjects, scheduler) : follow a set of globjects
+//
+// notes : the tree is built if the set (or its order) changed, or after
+//         REBUILD_REFITS refits. otherwise, it is only refitted.
+// -------------------------------------------------------------------------
+
+void BoundingHierarchy::update(const vec_globject& i_objects,
+                               Scheduler* i_scheduler)
+{
+  if (i_objects != m_objects) {
+    m_objects = i_objects;
+    build();
+  }
+  else if (m_refits >= REBUILD_REFITS) build();
+  else refit(i_scheduler);
+}
+
+// -------------------------------------------------------------------------
+// refit(scheduler) : read the bounding spheres again, and grow or shrink
+//                    the nodes to fit them
+//
+// notes : children always come after their parent in m_nodes, so the
+//         nodes are refitted in reverse order
+// -------------------------------------------------------------------------
+
+void BoundingHierarchy::refit(Scheduler* i_scheduler)
+{
+  Spheres spheres(m_items);
+  if (i_scheduler)
+    i_scheduler->parallelFor(m_items.size(), spheres, ITEMS_PER_JOB);
+  else
+    spheres.run(0, m_items.size());
+
+  for (int n = (int)m_nodes.size() - 1; n >= 0; n--) {
+    Node& node = m_nodes[n];
+    BoundingSphere bounds;
+    if (node.count) {
+      for (int i = node.first; i < node.first + node.count; i++)
+        bounds = bounds.theUnion(m_items[i].sphere);
+    }
+    else
+      bounds = m_nodes[node.left].bounds.theUnion(m_nodes[node.right].bounds);
+    node.bounds = bounds;
+  }
+  m_refits++;
+}
+
+void BoundingHierarchy::clear()
+{
+  m_objects.clear();
+  m_items.clear();
+  m_nodes.clear();
+  m_refits = 0;
+}
+
+// -------------------------------------------------------------------------
+// rayCast(ray, distance) : first bounding sphere on a ray
+//
+// distance     : if non-null, set to the distance to the hit
+// return value : the globject hit, 0 -> none
+//
+// notes : the closest child is searched first, the nodes farther than
+//         the closest hit so far are not searched
+// -------------------------------------------------------------------------
+
+Globject* BoundingHierarchy::rayCast(const Ray& i_ray,
+                                     double* o_distance) const
+{
+  if (m_nodes.empty()) return 0;
+
+  double    best = FAR_AWAY;
+  Globject* hit  = 0;
+  int stack[STACK_SIZE];
+  int size = 0;
+  stack[size++] = 0;
+
+  while (size) {
+    const Node& node = m_nodes[stack[--size]];
+    double t_near, t_far;
+    if (!i_ray.intersects(node.bounds, &t_near) || (t_near > best))
+      continue;
+
+    if (node.count) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        if (!i_ray.intersects(m_items[i].sphere, &t_near, &t_far))
+          continue;
+        // the origin may be inside : the ray hits on the way out
+        double t = (t_near >= 0. ? t_near : t_far);
+        if (t < best) { best = t; hit = m_items[i].object; }
+      }
+    }
+    else if (size + 2 <= STACK_SIZE) {
+      // the closest child is pushed last, to be searched first
+      const Vector& o = i_ray.origin();
+      const Vector& d = i_ray.direction();
+      double l = (m_nodes[node.left ].bounds.center() - o).dotProduct(d);
+      double r = (m_nodes[node.right].bounds.center() - o).dotProduct(d);
+      stack[size++] = (l < r ? node.right : node.left);
+      stack[size++] = (l < r ? node.left  : node.right);
+    }
+  }
+
+  if (hit && o_distance) *o_distance = best;
+  return hit;
+}
+
+// -------------------------------------------------------------------------
+// build() : build the tree over the globjects followed
+// -------------------------------------------------------------------------
+
+void BoundingHierarchy::build()
+{
+  m_items.resize(m_objects.size());
+  for (unsigned int i = 0; i < m_objects.size(); i++) {
+    m_items[i].object = m_objects[i];
+    m_items[i].sphere = m_objects[i]->boundingSphere();
+  }
+
+  m_nodes.clear();
+  m_refits = 0;
+  if (!m_items.empty()) build(0, m_items.size());
+}
+
+// -------------------------------------------------------------------------
+// build(first, count) : build the node over a range of m_items
+//
+// return value : the new node index
+//
+// notes : the range is split in two halves along the axis where the
+//         centers are the most spread out (the tree stays balanced)
+// -------------------------------------------------------------------------
+
+int BoundingHierarchy::build(int i_first, int i_count)
+{
+  int index = m_nodes.size();
+  m_nodes.push_back(Node());
+
+  Node node;
+  node.left  = node.right = -1;
+  node.first = i_first;
+  node.count = i_count;
+  if (i_count <= LEAF_SIZE) {
+    for (int i = i_first; i < i_first + i_count; i++)
+      node.bounds = node.bounds.theUnion(m_items[i].sphere);
+  }
+  else {
+    Vector lo = m_items[i_first].sphere.center(), hi = lo;
+    for (int i = i_first + 1; i < i_first + i_count; i++) {
+      const Vector& c = m_items[i].sphere.center();
+      lo.set(std::min(lo.x(), c.x()), std::min(lo.y(), c.y()),
+             std::min(lo.z(), c.z()));
+      hi.set(std::max(hi.x(), c.x()), std::max(hi.y(), c.y()),
+             std::max(hi.z(), c.z()));
+    }
+    Vector spread = hi - lo;
+    int axis = 0;
+    if (spread[1] > spread[axis]) axis = 1;
+    if (spread[2] > spread[axis]) axis = 2;
+
+    int half = i_count / 2;
+    vec_items::iterator first = m_items.begin() + i_first;
+    std::nth_element(first, first + half, first + i_count, ByAxis(axis));
+
+    node.count = 0;
+    node.left  = build(i_first, half);
+    node.right = build(i_first + half, i_count - half);
+    node.bounds =
+      m_nodes[node.left].bounds.theUnion(m_nodes[node.right].bounds);
+  }
+
+  // (m_nodes may have grown, the node is only stored now)
+  m_nodes[index] = node;
+  return index;
+}
@@ -0,0 +1,96 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef BOUNDINGHIERARCHY_H
+#define BOUNDINGHIERARCHY_H
+class   BoundingHierarchy;
+
+class Globject;
+class Ray;
+class Scheduler;
+#include "boundingsphere.h"
+#include <vector>
+
+class BoundingHierarchy
+//
+// BoundingHierarchy : tree of bounding spheres over a set of globjects
+//                     (bounding volume hierarchy), to find what a ray hits
+//                     without testing every globject
+//
+//   - the tree is built once for a set of globjects, then refitted to
+//     their new bounding spheres : the nodes keep their globjects, only
+//     their spheres grow or shrink
+//   - the tree is built again when the set changes, and now and then
+//     as the globjects wander away from their first neighbours
+//
+{
+ public:
+  typedef std::vector<Globject*> vec_globject;
+
+  BoundingHierarchy();
+
+  // follow a set of globjects (built again if it changed, else refitted)
+  void update(const vec_globject& i_objects, Scheduler* i_scheduler = 0);
+
+  // refit the tree to the current bounding spheres (read on all the
+  // scheduler threads, if any)
+  void refit(Scheduler* i_scheduler = 0);
+
+  // forget all the globjects
+  void clear();
+
+  // first globject whose bounding sphere is on the ray (0 -> none)
+  Globject* rayCast(const Ray& i_ray, double* o_distance = 0) const;
+
+ private:
+  struct Item
+  //
+  // Item : a globject and its bounding sphere, as of the last refit
+  //
+  {
+    Globject*      object;
+    BoundingSphere sphere;
+  };
+  struct Node
+  //
+  // Node : two children, or a few globjects (leaf)
+  //
+  {
+    BoundingSphere bounds;
+    int left, right;     // children (internal node)
+    int first, count;    // m_items range (leaf, count > 0)
+  };
+  struct ByAxis;
+  class  Spheres;
+  friend class Spheres;
+  typedef std::vector<Item> vec_items;
+  typedef std::vector<Node> vec_nodes;
+
+  void build();
+  int  build(int i_first, int i_count);
+
+  vec_globject m_objects;  // the globjects followed, as given
+  vec_items    m_items;    // the same, in leaf order
+  vec_nodes    m_nodes;    // the tree (root first, parents before children)
+  int          m_refits;   // refits since the tree was built
+};
+
+#endif // BOUNDINGHIERARCHY_H
@@ -102,7 +102,10 @@ BoundingSphere BoundingSphere::theUnion(const BoundingSphere& s) const
 }
 
 // -------------------------------------------------------------------------
-// applyTransform(tranform) : apply translation and scaling to the sphere
+// applyTransform(tranform) : apply the transformations to the sphere
+//
+// notes : the sphere still holds what it held, the radius is scaled by
+//         the largest scaling
 // -------------------------------------------------------------------------
 
 void BoundingSphere::applyTransform(const Transform& t)
@@ -116,8 +119,8 @@ void BoundingSphere::applyTransform(const Transform& t)
   if (s.z() > max) max = s.z();
   m_radius *= max;
 
-  // translation of the center
-  m_center = (m_center * max) + t.translation();
+  // the center is scaled, rotated and translated
+  m_center = t.applyTo(m_center);
 }
 
 const BoundingSphere& BoundingSphere::operator=(const BoundingSphere& obj)
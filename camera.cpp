@@ -21,6 +21,7 @@
 
 #include "camera.h"
 #include "vector.h"
+#include "ray.h"
 #include <QtOpenGL>
 #include <cmath>
 
@@ -160,3 +161,43 @@ void Camera::setAspectRatio(double v)
 {
   m_aspect_ratio = v;
 }
+
+// -------------------------------------------------------------------------
+// rotated(v, degrees, axis) : 'v' rotated around the x, y or z axis (0-2)
+// -------------------------------------------------------------------------
+
+static Vector rotated(const Vector& v, double degrees, int axis)
+{
+  double a = degrees * M_PI / 180.;
+  double c = cos(a), s = sin(a);
+  switch (axis) {
+  case 0 : return Vector(v.x(), v.y() * c - v.z() * s, v.y() * s + v.z() * c);
+  case 1 : return Vector(v.x() * c + v.z() * s, v.y(), v.z() * c - v.x() * s);
+  default: return Vector(v.x() * c - v.y() * s, v.x() * s + v.y() * c, v.z());
+  }
+}
+
+// -------------------------------------------------------------------------
+// ray(x, y) : ray from the camera through a point of the view
+//
+// notes : the view transformations of place() are undone, in reverse
+//         order, on the eye position and on the direction of the point
+// -------------------------------------------------------------------------
+
+Ray Camera::ray(double x, double y) const
+{
+  // in eye coordinates : the eye is at the origin, looking along -z
+  double h = tan(m_field_view_y * M_PI / 360.);
+  Vector dir(x * h * m_aspect_ratio, y * h, -1.);
+  Vector eye(0., 0., m_distance + CAM_NEAR);
+
+  // undo the roll, the tilt and the rotation
+  dir = rotated(dir,  m_roll_z,   2);
+  dir = rotated(dir, -m_tilt_x,   0);
+  dir = rotated(dir,  m_rotate_y, 1);
+  eye = rotated(eye,  m_roll_z,   2);
+  eye = rotated(eye, -m_tilt_x,   0);
+  eye = rotated(eye,  m_rotate_y, 1);
+
+  return Ray(eye + target(), dir);
+}
@@ -24,6 +24,7 @@
 class   Camera;
 
 class Vector;
+class Ray;
 
 class Camera
 //
@@ -66,6 +67,10 @@ class Camera
   // set the aspect ratio given by (width / height)
   void setAspectRatio(double v);
 
+  // ray from the camera through a point of the view
+  // (x, y within [-1, 1] : -1 -> left or bottom, 1 -> right or top)
+  Ray ray(double x, double y) const;
+
  private:
   double m_distance, m_range,    m_field_view_y;
   double m_target_x, m_target_y, m_target_z;
@@ -0,0 +1,385 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "contactsolver.h"
+#include "globject.h"
+#include "boundingsphere.h"
+#include "transform.h"
+#include <algorithm>
+#include <cmath>
+
+#define DEFAULT_ITERATIONS   8
+#define DEFAULT_RESTITUTION  0.3
+#define DEFAULT_FRICTION     0.3
+#define BOUNCE_THRESHOLD     0.5    // slower contacts don't bounce (m/s)
+#define PENETRATION_SLOP     0.0005 // penetration left alone (m)
+#define PENETRATION_FIX      0.8    // part of the rest corrected each solve
+
+// -------------------------------------------------------------------------
+// impulses are kept sorted by pair of bodies
+// -------------------------------------------------------------------------
+
+static bool lessPair(const ContactSolver::Impulse& i_a,
+                     const ContactSolver::Impulse& i_b)
+{
+  if (i_a.a != i_b.a) return (i_a.a < i_b.a);
+  return (i_a.b < i_b.b);
+}
+
+ContactSolver::ContactSolver()
+  :m_iterations(DEFAULT_ITERATIONS),
+   m_restitution(DEFAULT_RESTITUTION),
+   m_friction(DEFAULT_FRICTION),
+   m_bodies(),
+   m_contacts(),
+   m_sweep(),
+   mp_objects(0),
+   m_impulses(),
+   m_kept()
+{
+}
+
+// -------------------------------------------------------------------------
+// (set)iterations, (set)restitution, (set)friction : solver tunables
+// -------------------------------------------------------------------------
+
+void ContactSolver::setIterations(int i_iterations)
+{
+  m_iterations = (i_iterations > 0 ? i_iterations : 1);
+}
+
+int ContactSolver::iterations() const
+{
+  return m_iterations;
+}
+
+void ContactSolver::setRestitution(double i_restitution)
+{
+  m_restitution = (i_restitution < 0. ? 0. :
+                   (i_restitution > 1. ? 1. : i_restitution));
+}
+
+double ContactSolver::restitution() const
+{
+  return m_restitution;
+}
+
+void ContactSolver::setFriction(double i_friction)
+{
+  m_friction = (i_friction > 0. ? i_friction : 0.);
+}
+
+double ContactSolver::friction() const
+{
+  return m_friction;
+}
+
+// -------------------------------------------------------------------------
+// impulses(), setImpulses(impulses), clear(), forget(body) : impulses
+//                                              kept for warm starting
+// -------------------------------------------------------------------------
+
+const ContactSolver::vec_impulses& ContactSolver::impulses() const
+{
+  return m_impulses;
+}
+
+void ContactSolver::setImpulses(const vec_impulses& i_impulses)
+{
+  m_impulses = i_impulses;
+  std::sort(m_impulses.begin(), m_impulses.end(), lessPair);
+}
+
+void ContactSolver::clear()
+{
+  m_impulses.clear();
+  m_kept.clear();
+}
+
+void ContactSolver::forget(const Globject* i_body)
+{
+  unsigned int kept = 0;
+  for (unsigned int i = 0; i < m_impulses.size(); i++)
+    if ((m_impulses[i].a != i_body) && (m_impulses[i].b != i_body))
+      m_impulses[kept++] = m_impulses[i];
+  m_impulses.resize(kept);
+}
+
+// -------------------------------------------------------------------------
+// addContact(a, b, normal, depth) : new contact, with the impulses kept
+//                                   for the pair, if any
+// -------------------------------------------------------------------------
+
+void ContactSolver::addContact(int i_a, int i_b, const Vector& i_normal,
+                               double i_depth)
+{
+  const Body& a = m_bodies[i_a];
+  double inverse = a.inverse + (i_b >= 0 ? m_bodies[i_b].inverse : 0.);
+
+  Contact c;
+  c.a      = i_a;
+  c.b      = i_b;
+  c.normal = i_normal;
+  c.depth  = i_depth;
+  c.mass   = 1. / inverse;
+  c.normal_impulse = 0.;
+
+  // only fast enough contacts bounce (resting ones would jitter)
+  Vector velocity = (i_b >= 0 ? m_bodies[i_b].velocity : Vector());
+  double closing = (velocity - a.velocity).dotProduct(i_normal);
+  c.bounce = (closing < -BOUNCE_THRESHOLD ? -m_restitution * closing : 0.);
+
+  Impulse key;
+  key.a = (*mp_objects)[i_a];
+  key.b = (i_b >= 0 ? (*mp_objects)[i_b] : 0);
+  vec_impulses::const_iterator it =
+    std::lower_bound(m_impulses.begin(), m_impulses.end(), key, lessPair);
+  if ((it != m_impulses.end()) && !lessPair(key, *it)) {
+    // the normal may have turned a little since then
+    c.normal_impulse  = (*it).normal;
+    c.tangent_impulse = (*it).tangent -
+      i_normal * (*it).tangent.dotProduct(i_normal);
+  }
+  m_contacts.push_back(c);
+}
+
+// -------------------------------------------------------------------------
+// deepest(a, b, normal, depth) : deepest overlap of two collision shapes
+//                                (their outer bounding spheres overlap)
+//
+// normal       : from 'a' to 'b'
+// return value : 'false' if the shapes don't touch
+// -------------------------------------------------------------------------
+
+bool ContactSolver::deepest(int i_a, int i_b, Vector& o_normal,
+                            double& o_depth)
+{
+  for (int k = 0; k < 2; k++) {
+    Body& body = m_bodies[k ? i_b : i_a];
+    if (body.first >= 0) continue;
+    body.first = m_parts.size();
+    body.parts = (*mp_objects)[k ? i_b : i_a]->colliders(m_parts);
+  }
+  const Body& a = m_bodies[i_a];
+  const Body& b = m_bodies[i_b];
+  int parts_a = (a.parts ? a.parts : 1);
+  int parts_b = (b.parts ? b.parts : 1);
+
+  bool found = false;
+  for (int p = 0; p < parts_a; p++) {
+    Vector center_a = (a.parts ? m_parts[a.first + p].center() : a.center);
+    double radius_a = (a.parts ? m_parts[a.first + p].radius() : a.radius);
+
+    for (int q = 0; q < parts_b; q++) {
+      Vector direction =
+        (b.parts ? m_parts[b.first + q].center() : b.center) - center_a;
+      double reach = radius_a +
+        (b.parts ? m_parts[b.first + q].radius() : b.radius);
+      double distance2 = direction.dotProduct(direction);
+      if (distance2 >= reach * reach) continue;
+
+      double distance = sqrt(distance2);
+      if (found && (reach - distance <= o_depth)) continue;
+      found    = true;
+      o_depth  = reach - distance;
+      o_normal = (distance > 0. ? direction / distance : Vector(0., 1., 0.));
+    }
+  }
+  return found;
+}
+
+// -------------------------------------------------------------------------
+// apply(contact, impulse) : push the contact bodies apart
+// -------------------------------------------------------------------------
+
+void ContactSolver::apply(const Contact& i_contact, const Vector& i_impulse)
+{
+  Body& a = m_bodies[i_contact.a];
+  a.velocity -= i_impulse * a.inverse;
+  if (i_contact.b >= 0) {
+    Body& b = m_bodies[i_contact.b];
+    b.velocity += i_impulse * b.inverse;
+  }
+}
+
+// -------------------------------------------------------------------------
+// solve(objects, limits, contacts) : solve the collisions between the
+//                                    objects, and with the limits
+//
+// limits   : the objects must stay inside (none if null)
+// contacts : if non-null, the pairs of objects that collided are appended
+// return value : 'true' if one of the objects was moved
+// -------------------------------------------------------------------------
+
+bool ContactSolver::solve(const vec_globject& i_objects,
+                          const BoundingSphere& i_limits,
+                          Physics::vec_contacts* o_contacts)
+{
+  static const double DENSITY_VOLUME = 4. / 3. * M_PI;
+
+  mp_objects = &i_objects;
+  int count = i_objects.size();
+  m_bodies.resize(count);
+  m_contacts.clear();
+  m_sweep.clear();
+  m_parts.clear();
+
+  for (int i = 0; i < count; i++) {
+    Globject* o = i_objects[i];
+    BoundingSphere bs = o->boundingSphere();
+    Body& body    = m_bodies[i];
+    body.center   = bs.center();
+    body.radius   = bs.radius();
+    body.velocity = o->velocity();
+    body.inverse  = 0.;
+    body.correction = Vector();
+    body.first    = -1;
+    body.parts    = 0;
+    if (o->movable() && (body.radius > 0.))
+      body.inverse = 1. / (DENSITY_VOLUME * pow(body.radius, 3));
+    m_sweep.push_back(std::make_pair(body.center.x() - body.radius, i));
+  }
+
+  // contacts with the limits (the objects are inside). distance - radius
+  // is (distance^2 - radius^2) / (distance + radius), and the difference
+  // of squares is the product of the distances to the bottom and to the
+  // top of the limits : the depth stays precise at the bottom of a huge
+  // sphere (the floor), far from its center
+  if (!i_limits.isNull()) {
+    Vector lift(0., i_limits.radius(), 0.);
+    Vector bottom = i_limits.center() - lift;
+    Vector top    = i_limits.center() + lift;
+    for (int i = 0; i < count; i++) {
+      const Body& body = m_bodies[i];
+      if (body.inverse == 0.) continue;
+
+      Vector direction = body.center - i_limits.center();
+      double distance  = direction.l2norm();
+      double squares   = (body.center - bottom).dotProduct(body.center - top);
+      double depth = squares / (distance + i_limits.radius()) + body.radius;
+      if ((depth > 0.) && (distance > 0.))
+        addContact(i, -1, direction / distance, depth);
+    }
+  }
+
+  // contacts between the objects (sweep along x)
+  std::sort(m_sweep.begin(), m_sweep.end());
+  for (int k = 0; k < count; k++) {
+    int i = m_sweep[k].second;
+    const Body& a = m_bodies[i];
+    double right = a.center.x() + a.radius;
+
+    for (int l = k + 1; (l < count) && (m_sweep[l].first <= right); l++) {
+      int j = m_sweep[l].second;
+      const Body& b = m_bodies[j];
+      if ((a.inverse == 0.) && (b.inverse == 0.)) continue;
+
+      Vector direction = b.center - a.center;
+      double reach = a.radius + b.radius;
+      if (direction.dotProduct(direction) >= reach * reach) continue;
+
+      // then their collision shapes (the first body of a pair is always
+      // the first child)
+      int first = (i < j ? i : j), second = (i < j ? j : i);
+      Vector normal;
+      double depth;
+      if (deepest(first, second, normal, depth))
+        addContact(first, second, normal, depth);
+    }
+  }
+  if (m_contacts.empty()) {
+    m_impulses.clear();
+    return false;
+  }
+
+  // warm start (once all the bounces are known)
+  for (unsigned int k = 0; k < m_contacts.size(); k++) {
+    const Contact& c = m_contacts[k];
+    apply(c, c.normal * c.normal_impulse + c.tangent_impulse);
+  }
+
+  // sequential impulses : each contact in turn, a few times
+  for (int n = 0; n < m_iterations; n++) {
+    for (unsigned int k = 0; k < m_contacts.size(); k++) {
+      Contact& c = m_contacts[k];
+      const Body& a = m_bodies[c.a];
+      Vector relative = (c.b >= 0 ? m_bodies[c.b].velocity : Vector()) -
+                        a.velocity;
+
+      // along the normal : the total impulse may only push
+      double impulse = c.normal_impulse +
+        c.mass * (c.bounce - relative.dotProduct(c.normal));
+      if (impulse < 0.) impulse = 0.;
+      apply(c, c.normal * (impulse - c.normal_impulse));
+      c.normal_impulse = impulse;
+
+      // across the normal : friction, within the friction cone
+      if ((c.b < 0) || (m_friction == 0.)) continue;
+      relative = m_bodies[c.b].velocity - a.velocity;
+      Vector slide = relative - c.normal * relative.dotProduct(c.normal);
+      Vector tangent = c.tangent_impulse - slide * c.mass;
+      double limit = m_friction * c.normal_impulse;
+      double length = tangent.l2norm();
+      if (length > limit) tangent *= (limit / length);
+      apply(c, tangent - c.tangent_impulse);
+      c.tangent_impulse = tangent;
+    }
+  }
+
+  // what is left of the penetrations, shared by mass
+  for (unsigned int k = 0; k < m_contacts.size(); k++) {
+    const Contact& c = m_contacts[k];
+    double depth = c.depth - PENETRATION_SLOP;
+    if (depth <= 0.) continue;
+
+    Vector push = c.normal * (depth * PENETRATION_FIX * c.mass);
+    m_bodies[c.a].correction -= push * m_bodies[c.a].inverse;
+    if (c.b >= 0) m_bodies[c.b].correction += push * m_bodies[c.b].inverse;
+  }
+
+  // new velocities and positions, impulses kept for the next solve
+  for (int i = 0; i < count; i++) {
+    Globject* o = i_objects[i];
+    if (m_bodies[i].inverse == 0.) continue;
+    if (!(m_bodies[i].velocity - o->velocity()).isNull())
+      o->setVelocity(m_bodies[i].velocity);
+    if (!m_bodies[i].correction.isNull())
+      o->transform().addTranslation(m_bodies[i].correction);
+  }
+
+  m_kept.clear();
+  for (unsigned int k = 0; k < m_contacts.size(); k++) {
+    const Contact& c = m_contacts[k];
+    Impulse kept;
+    kept.a       = i_objects[c.a];
+    kept.b       = (c.b >= 0 ? i_objects[c.b] : 0);
+    kept.normal  = c.normal_impulse;
+    kept.tangent = c.tangent_impulse;
+    m_kept.push_back(kept);
+
+    if (o_contacts && (c.b >= 0))
+      o_contacts->push_back(Physics::Contact(i_objects[c.a],
+                                             i_objects[c.b]));
+  }
+  std::sort(m_kept.begin(), m_kept.end(), lessPair);
+  m_impulses.swap(m_kept);
+  return true;
+}
@@ -0,0 +1,147 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef CONTACTSOLVER_H
+#define CONTACTSOLVER_H
+class   ContactSolver;
+
+#include "boundingsphere.h"
+#include "globject.h"
+#include "physics.h"
+#include "vector.h"
+#include <vector>
+
+class ContactSolver
+//
+// ContactSolver : sequential impulse solver for the collisions between
+//                 bounding spheres (and with the container limits)
+//
+//   - a body weighs as much as the volume of its bounding sphere (all the
+//     bodies have the same density), bodies that aren't movable can't be
+//     pushed at all
+//   - bodies touch if their outer bounding spheres do, then if their
+//     collision shapes do (see Globject::colliders), the deepest overlap
+//     of two shapes makes the contact. the container limits only see the
+//     outer bounding spheres.
+//   - the impulse along each contact normal (bounce, with restitution) and
+//     across it (friction, at most 'friction' times the normal impulse) is
+//     solved for all the contacts at once, in a few iterations
+//   - the impulses found for each pair of bodies are kept, and applied
+//     again the next time the pair touches (warm starting) : resting
+//     bodies need few iterations to stay at rest
+//   - what is left of the penetrations is corrected on the positions,
+//     shared by mass
+//
+{
+ public:
+  typedef std::vector<Globject*> vec_globject;
+
+  struct Impulse
+  //
+  // Impulse : impulses kept for a pair of bodies, per unit of density
+  //
+  {
+    const Globject* a;       // first body
+    const Globject* b;       // second body (0 -> the container limits)
+    double          normal;  // along the normal, from 'a' to 'b'
+    Vector          tangent; // friction
+  };
+  typedef std::vector<Impulse> vec_impulses;
+
+  ContactSolver();
+
+  // solver iterations for each step (8 by default)
+  void setIterations(int i_iterations);
+  int  iterations() const;
+
+  // velocity kept by a bounce, along the normal (0 -> none, 1 -> all)
+  void   setRestitution(double i_restitution);
+  double restitution() const;
+
+  // friction between bodies (impulse across the normal / along it),
+  // not with the container limits
+  void   setFriction(double i_friction);
+  double friction() const;
+
+  // solve the collisions between the objects and with the limits
+  // (the pairs of objects that collided are appended to 'contacts')
+  bool solve(const vec_globject& i_objects, const BoundingSphere& i_limits,
+             Physics::vec_contacts* o_contacts = 0);
+
+  // impulses kept for warm starting (to save and restore the solver)
+  const vec_impulses& impulses() const;
+  void setImpulses(const vec_impulses& i_impulses);
+  void clear();
+
+  // forget the impulses of a body leaving the scene
+  void forget(const Globject* i_body);
+
+ private:
+  struct Body
+  //
+  // Body : a solved object, as of the beginning of the solve
+  //
+  {
+    Vector center;    // outer bounding sphere
+    double radius;
+    int    first;     // collision shape in m_parts (-1 : not read yet)
+    int    parts;     // (0 : the outer bounding sphere only)
+    double inverse;   // inverse mass (0 -> not movable)
+    Vector velocity;
+    Vector correction; // of the position, for the penetrations
+  };
+
+  struct Contact
+  //
+  // Contact : two touching bodies
+  //
+  {
+    int    a, b;      // bodies (b = -1 -> the container limits)
+    Vector normal;    // from 'a' to 'b'
+    double depth;     // penetration (m)
+    double mass;      // effective mass along the normal
+    double bounce;    // velocity wanted along the normal after solving
+    double normal_impulse;
+    Vector tangent_impulse;
+  };
+
+  typedef std::vector<Body>                  vec_bodies;
+  typedef std::vector<Contact>               vec_contacts;
+  typedef std::vector<std::pair<double, int> > vec_sweep;
+  typedef Globject::vec_spheres              vec_spheres;
+
+  void addContact(int i_a, int i_b, const Vector& i_normal, double i_depth);
+  bool deepest(int i_a, int i_b, Vector& o_normal, double& o_depth);
+  void apply(const Contact& i_contact, const Vector& i_impulse);
+
+  int          m_iterations;
+  double       m_restitution;
+  double       m_friction;
+  vec_bodies   m_bodies;      // current solve
+  vec_contacts m_contacts;
+  vec_sweep    m_sweep;       // bodies sorted along x
+  vec_spheres  m_parts;       // collision shapes read so far
+  const vec_globject* mp_objects;
+  vec_impulses m_impulses;    // kept from the last solve (sorted)
+  vec_impulses m_kept;        // being kept by the current solve
+};
+
+#endif // CONTACTSOLVER_H
@@ -81,8 +81,8 @@ void Cylinder::setInnerRadius(double i_top_radius, double i_bas_radius)
       addChild(mp_tube_inner);
 
       // set the material if one has been applied before
-      const Material* p = mp_tube_outer->material();
-      if (p) mp_tube_inner->setMaterial(*p);
+      MaterialRegistry::Id id = mp_tube_outer->material();
+      if (id != MaterialRegistry::NONE) mp_tube_inner->setMaterial(id);
     }
     else {
       // or adjust the radius of the current one
@@ -99,6 +99,11 @@ void Cylinder::setTexture(Texture* i_texture)
 }
 
 void Cylinder::setMaterial(const Material& i_material)
+{
+  setMaterial(MaterialRegistry::intern(i_material));
+}
+
+void Cylinder::setMaterial(MaterialRegistry::Id i_material)
 {
   for (vec_globject::const_iterator it = children().begin();
        it != children().end(); it++)
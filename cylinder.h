@@ -28,6 +28,7 @@ class Material;
 class Disk;
 class Tube;
 #include "globject.h"
+#include "materialregistry.h"
 
 class Cylinder : public Globject
 //
@@ -48,6 +49,7 @@ class Cylinder : public Globject
   void setInnerRadius(double i_top_radius, double i_bas_radius);
   void setTexture(Texture* i_texture);
   void setMaterial(const Material& i_material);
+  void setMaterial(MaterialRegistry::Id i_material);
 
   // subdivision settings
   bool setSlices(int i_slices);
@@ -0,0 +1,194 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "flock.h"
+#include "globject.h"
+#include <algorithm>
+#include <cmath>
+
+#define NEIGHBOUR_RADIUS   2.5    // neighbours are within (m)
+#define SEPARATION_RADIUS  1.2    // too close within (m)
+#define FLEE_RADIUS        15.    // balls are scary within (m)
+
+#define SEPARATION_WEIGHT  4.     // accelerations (m/s^2) for each rule
+#define ALIGNMENT_WEIGHT   0.5
+#define COHESION_WEIGHT    0.3
+#define FLEE_WEIGHT        12.
+
+#define MAX_ACCELERATION   6.     // m/s^2
+#define MIN_ACCELERATION   0.05   // below that, the sheep is left alone
+#define WALK_SPEED         1.5    // herd speed (m/s)
+#define FLEE_SPEED         6.     // running away from a ball (m/s)
+#define GROUND_EPSILON     0.01   // max. y-velocity to be on the ground
+#define MAX_CELLS          256    // more cells on a side -> larger cells
+
+Flock::Flock()
+  :m_x(), m_z(),
+   m_vx(), m_vz(),
+   m_ground(),
+   m_left(0.), m_top(0.),
+   m_columns(0), m_rows(0),
+   m_cell(NEIGHBOUR_RADIUS),
+   m_first(),
+   m_cells(),
+   m_slots(),
+   m_sorted()
+{
+}
+
+// -------------------------------------------------------------------------
+// steer(seconds, herd, threats) : steer the herd for 'seconds'
+//
+// herd    : the sheep to steer
+// threats : the sheep flee from those (the Big Red Balls)
+//
+// notes : the velocities are all computed from the same state, then
+//         changed at once. sheep in the air (falling, jumping) can't
+//         steer. a sheep at rest stays at rest, unless something is
+//         worth moving for (see MIN_ACCELERATION).
+// -------------------------------------------------------------------------
+
+void Flock::steer(double i_sec, const vec_globject& i_herd,
+                  const vec_globject& i_threats)
+{
+  int n = i_herd.size();
+  m_x.resize(n); m_z.resize(n); m_vx.resize(n); m_vz.resize(n);
+  m_ground.resize(n);
+  for (int i = 0; i < n; i++) {
+    Vector pos = i_herd[i]->position();
+    const Vector& vel = i_herd[i]->velocity();
+    m_x[i]  = pos.x();  m_z[i]  = pos.z();
+    m_vx[i] = vel.x();  m_vz[i] = vel.z();
+    m_ground[i] = (fabs(vel.y()) < GROUND_EPSILON);
+  }
+  sort();
+
+  static const double R2 = NEIGHBOUR_RADIUS * NEIGHBOUR_RADIUS;
+  static const double S2 = SEPARATION_RADIUS * SEPARATION_RADIUS;
+
+  for (int i = 0; i < n; i++) {
+    if (!m_ground[i]) continue;
+    double x = m_x[i], z = m_z[i];
+    const double* self = &m_sorted[m_slots[i] * 4];
+    double sep_x = 0., sep_z = 0.;   // separation
+    double ali_x = 0., ali_z = 0.;   // alignment
+    double coh_x = 0., coh_z = 0.;   // cohesion
+    int count = 0;
+
+    // the neighbours, in the cells around
+    int column = m_cells[i] % m_columns, row = m_cells[i] / m_columns;
+    for (int r = (row ? row - 1 : 0); r <= row + 1 && r < m_rows; r++) {
+      int c0 = (column ? column - 1 : 0);
+      int c1 = (column + 1 < m_columns ? column + 1 : column);
+      const double* other = &m_sorted[m_first[r * m_columns + c0] * 4];
+      const double* end   = &m_sorted[m_first[r * m_columns + c1 + 1] * 4];
+      for (; other < end; other += 4) {
+        double dx = x - other[0], dz = z - other[1];
+        double d2 = dx * dx + dz * dz;
+        if ((d2 >= R2) || (other == self)) continue;
+
+        if ((d2 < S2) && (d2 > 0.)) {
+          double f = 1. / sqrt(d2) - 1. / SEPARATION_RADIUS;
+          sep_x += dx * f; sep_z += dz * f;
+        }
+        ali_x += other[2]; ali_z += other[3];
+        coh_x -= dx;       coh_z -= dz;
+        count++;
+      }
+    }
+    if (count) {
+      ali_x = ali_x / count - m_vx[i]; ali_z = ali_z / count - m_vz[i];
+      coh_x /= count;                  coh_z /= count;
+    }
+
+    // the balls around
+    double flee_x = 0., flee_z = 0., scared = 0.;
+    for (unsigned int t = 0; t < i_threats.size(); t++) {
+      Vector ball = i_threats[t]->position();
+      double dx = x - ball.x(), dz = z - ball.z();
+      double d = sqrt(dx * dx + dz * dz);
+      if ((d >= FLEE_RADIUS) || (d == 0.)) continue;
+      double fear = 1. - d / FLEE_RADIUS;
+      flee_x += dx / d * fear; flee_z += dz / d * fear;
+      if (fear > scared) scared = fear;
+    }
+
+    Vector accel(sep_x  * SEPARATION_WEIGHT + ali_x * ALIGNMENT_WEIGHT +
+                 coh_x  * COHESION_WEIGHT   + flee_x * FLEE_WEIGHT, 0.,
+                 sep_z  * SEPARATION_WEIGHT + ali_z * ALIGNMENT_WEIGHT +
+                 coh_z  * COHESION_WEIGHT   + flee_z * FLEE_WEIGHT);
+    double a = accel.l2norm();
+    if (a < MIN_ACCELERATION) continue;
+    if (a > MAX_ACCELERATION) accel *= MAX_ACCELERATION / a;
+
+    // faster when running away
+    Vector vel = i_herd[i]->velocity() + accel * i_sec;
+    double speed = vel.l2norm();
+    double max_speed = WALK_SPEED + (FLEE_SPEED - WALK_SPEED) * scared;
+    if (speed > max_speed) vel *= max_speed / speed;
+    i_herd[i]->setVelocity(vel);
+  }
+}
+
+// -------------------------------------------------------------------------
+// sort() : sort the herd in a grid covering it (counting sort)
+//
+// notes : the sheep of a cell are contiguous in m_sorted, and so are the
+//         sheep of a row of cells : the neighbours are read in order
+// -------------------------------------------------------------------------
+
+void Flock::sort()
+{
+  int n = m_x.size();
+  double right = 0., bottom = 0.;
+  m_left = m_top = 0.;
+  for (int i = 0; i < n; i++) {
+    if ((i == 0) || (m_x[i] < m_left)) m_left  = m_x[i];
+    if ((i == 0) || (m_x[i] > right))  right   = m_x[i];
+    if ((i == 0) || (m_z[i] < m_top))  m_top   = m_z[i];
+    if ((i == 0) || (m_z[i] > bottom)) bottom  = m_z[i];
+  }
+
+  double side = std::max(right - m_left, bottom - m_top);
+  m_cell    = std::max((double)NEIGHBOUR_RADIUS, side / MAX_CELLS);
+  m_columns = (int)((right  - m_left) / m_cell) + 1;
+  m_rows    = (int)((bottom - m_top)  / m_cell) + 1;
+
+  m_first.assign(m_columns * m_rows + 1, 0);
+  m_cells.resize(n);
+  for (int i = 0; i < n; i++) {
+    int c = (int)((m_x[i] - m_left) / m_cell);
+    int r = (int)((m_z[i] - m_top)  / m_cell);
+    m_cells[i] = r * m_columns + c;
+    m_first[m_cells[i] + 1]++;
+  }
+  for (unsigned int c = 1; c < m_first.size(); c++)
+    m_first[c] += m_first[c - 1];
+
+  m_slots.resize(n);
+  m_sorted.resize(n * 4 + 4);
+  vec_ints next(m_first.begin(), m_first.end() - 1);
+  for (int i = 0; i < n; i++) {
+    int k = m_slots[i] = next[m_cells[i]]++;
+    m_sorted[k * 4]     = m_x[i];  m_sorted[k * 4 + 1] = m_z[i];
+    m_sorted[k * 4 + 2] = m_vx[i]; m_sorted[k * 4 + 3] = m_vz[i];
+  }
+}
@@ -0,0 +1,75 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef FLOCK_H
+#define FLOCK_H
+class   Flock;
+
+class Globject;
+#include "vector.h"
+#include <vector>
+
+class Flock
+//
+// Flock : herd behaviour (boids), each sheep on the ground is steered by
+//         its neighbours and by the Big Red Balls around it
+//
+//   - separation : keep some room from the closest neighbours
+//   - alignment  : go the way the neighbours go
+//   - cohesion   : stay close to the neighbours
+//   - fleeing    : run away from the balls that come too close
+//
+//   the herd is sorted in a uniform grid at each step (cells as large as
+//   the neighbourhood), a sheep only looks at the few sheep in the cells
+//   around its own
+//
+{
+ public:
+  typedef std::vector<Globject*> vec_globject;
+
+  Flock();
+
+  // steer the herd for 'seconds', away from the threats
+  void steer(double i_sec, const vec_globject& i_herd,
+             const vec_globject& i_threats);
+
+ private:
+  typedef std::vector<double> vec_doubles;
+  typedef std::vector<int>    vec_ints;
+
+  void sort();
+
+  // the herd on the floor (x, z), as of the beginning of the step
+  vec_doubles m_x, m_z;      // positions
+  vec_doubles m_vx, m_vz;    // velocities
+  vec_ints    m_ground;      // 1 -> on the ground, can steer
+
+  // the grid : the herd sorted by cell, and where each cell starts
+  double      m_left, m_top; // grid corner (smallest x, z)
+  int         m_columns, m_rows;
+  double      m_cell;        // size of a cell (m)
+  vec_ints    m_first;       // (one more, where the last cell ends)
+  vec_ints    m_cells;       // cell of each sheep
+  vec_ints    m_slots;       // where each sheep was sorted
+  vec_doubles m_sorted;      // x, z, vx, vz of the sorted sheep
+};
+
+#endif // FLOCK_H
@@ -21,6 +21,11 @@
 
 #include "gldemowidget.h"
 #include "boundingsphere.h"
+#include "ray.h"
+#include "sceneloader.h"
+#include "texture.h"
+#include "materialregistry.h"
+#include "lightingshader.h"
 #include "vector.h"
 #include <QtOpenGL>
 #include <QCursor>
@@ -31,36 +36,117 @@
 #define ZERO_100KMH_DELAY     15.  // seconds to go from 0 to 100 kmh
 #define FRICTION_COMPENSATION 0.5  // extra acceleration to fight friction
 
+#define SCENE_STEP      (1. / 60.) // the scene is simulated at a fixed rate
+#define MAX_LAG         0.25       // longest time simulated in one frame
+#define MEMORY_LOG      60.        // seconds between two memory log lines
+
 #define DEGREES_PER_PIXEL   (360./800.)  // camera / mouse control precision
+
+// frame graph (see drawFrameGraph), in pixels
+#define GRAPH_FRAMES    120        // frames shown
+#define GRAPH_BAR       2          // width of a frame
+#define GRAPH_LANE      24         // height of a thread lane
+#define GRAPH_GAP       4          // between two lanes
+#define GRAPH_MARGIN    8          // from the top left corner
 #define TARGET_ACCELERATION (100000. / (3600. * ZERO_100KMH_DELAY)) // m/s^2
 
 GLDemoWidget::GLDemoWidget(QWidget* parent)
   :QGLWidget(parent),
+   m_scheduler(),
    m_scene (),
    m_camera(0., CAMERA_RANGE),
    m_mouse_grab(false),
    m_mouse_pos(),
-   m_big_ball(false)
+   m_big_ball(false),
+   mp_followed(0),
+   m_painted(false),
+   m_lag(0.),
+   m_moving(false),
+   m_frame_graph(false),
+   m_times(),
+   m_busy(),
+   m_busy_frame(0),
+   m_memory_log(0.)
 {
   // initial camera position
   m_camera.setRotate(-37.5);
+
+  // the scene is stepped by all the processors
+  m_scene.setScheduler(&m_scheduler);
+  m_busy.assign(GRAPH_FRAMES * (m_scheduler.workers() + 1), 0.f);
 }
 
 // -------------------------------------------------------------------------
-// tick(ms, up, left, down, right) : called each time a new frame is needed
+// tick(seconds, up, left, down, right) : called each time a new frame is
+//                                        needed
 //
-// ms                    = 1/1000 seconds elapsed since last tick
+// seconds               = time elapsed since last tick
 // up, left, down, right = current button states ('true' -> pressed)
+// return value          : 'true' if the widget was drawn since last tick
+//                         (false -> nothing visible is happening)
+//
+// notes : the scene is stepped SCENE_STEP seconds at a time, whatever the
+//         frame rate. the time left is drawn by interpolation (see
+//         paintGL). a frame too long to catch up with (more than MAX_LAG
+//         seconds) slows the scene down instead.
 // -------------------------------------------------------------------------
 
-void GLDemoWidget::tick(int i_ms,
+bool GLDemoWidget::tick(double i_sec,
                         bool i_up, bool i_left, bool i_down, bool i_right)
+{
+  m_lag += i_sec;
+  if (m_lag > MAX_LAG) m_lag = MAX_LAG;
+
+  // a paged world is loaded around what the camera looks at
+  m_scene.setFocus(m_camera.target());
+
+  int  steps = 0;
+  bool moved = false;
+  while (m_lag >= SCENE_STEP) {
+    steer(SCENE_STEP, i_up, i_left, i_down, i_right);
+    if (m_scene.step(SCENE_STEP)) moved = true;
+    m_lag -= SCENE_STEP;
+    steps++;
+  }
+
+  // refresh display if necessary. while the scene is moving, each frame
+  // is drawn, even without a new step (the interpolation moves on)
+  if (steps) m_moving = moved;
+  if (m_moving || m_frame_graph) updateGL();
+
+  // how busy was each thread during this frame (see drawFrameGraph)
+  m_scheduler.busyTimes(m_times);
+  int threads = m_times.size();
+  for (int t = 0; t < threads; t++)
+    m_busy[m_busy_frame * threads + t] =
+      (i_sec > 0.) ? (float)(m_times[t] / i_sec) : 0.f;
+  m_busy_frame = (m_busy_frame + 1) % GRAPH_FRAMES;
+
+  // memory footprint, once in a while (see MemoryStats)
+  m_memory_log += i_sec;
+  if (m_memory_log >= MEMORY_LOG) {
+    m_memory_log = 0.;
+    qDebug("memory : %s",
+           m_scene.memoryStats().toString().toLocal8Bit().constData());
+  }
+
+  bool painted = m_painted;
+  m_painted = false;
+  return painted;
+}
+
+// -------------------------------------------------------------------------
+// steer(seconds, up, left, down, right) : accelerate the current target
+// -------------------------------------------------------------------------
+
+void GLDemoWidget::steer(double i_sec,
+                         bool i_up, bool i_left, bool i_down, bool i_right)
 {
   // first of all, we make sure we won't care for useless stuff
   if (i_up   && i_down ) { i_up   = false; i_down  = false; }
   if (i_left && i_right) { i_left = false; i_right = false; }
 
-  const Globject* pt = m_scene.target((m_big_ball ? 1 : 0));
+  const Globject* pt = target();
   if (pt) {
     Vector vel = pt->velocity();
     if (fabs(vel.y()) < JUMP_EPSILON) {
@@ -89,8 +175,8 @@ void GLDemoWidget::tick(int i_ms,
           dec_right = 0.;
 
         // calculate velocity gain using TARGET_ACCELERATION
-        double vel_gain = TARGET_ACCELERATION  * ((double)i_ms / 1000.);
-        vel_gain *= 1. + FRICTION_COMPENSATION * ((double)i_ms / 1000.);
+        double vel_gain = TARGET_ACCELERATION  * i_sec;
+        vel_gain *= 1. + FRICTION_COMPENSATION * i_sec;
         vel_gain *= (((i_up || i_down) && (i_left || i_right)) ? 0.5 : 1.0);
 
         // accelerate (your breath)
@@ -110,9 +196,42 @@ void GLDemoWidget::tick(int i_ms,
       ((Globject*)pt)->setVelocity(vel);
     }
   }
+}
+
+// -------------------------------------------------------------------------
+// target() : current target, followed by the camera and steered
+//
+// notes : the hero, or the Big Red Ball, unless another body was picked
+//         with the mouse
+// -------------------------------------------------------------------------
+
+const Globject* GLDemoWidget::target() const
+{
+  if (mp_followed) return mp_followed;
+  return m_scene.target((m_big_ball ? 1 : 0));
+}
 
-  // animate the scene and refresh display if necessary
-  if (m_scene.tick(i_ms)) updateGL();
+// -------------------------------------------------------------------------
+// follow(position) : follow the body under the mouse
+//
+// position     : mouse position, in widget coordinates
+// return value : false -> there is no body under the mouse
+// -------------------------------------------------------------------------
+
+bool GLDemoWidget::follow(const QPoint& i_pos)
+{
+  if ((width() <= 0) || (height() <= 0)) return false;
+  double x = 2. * (i_pos.x() + 0.5) / width()  - 1.;
+  double y = 1. - 2. * (i_pos.y() + 0.5) / height();
+
+  const Globject* picked = m_scene.pick(m_camera.ray(x, y));
+  if (!picked) return false;
+
+  // the hero and the Big Red Ball are still targets 0 and 1
+  m_big_ball  = (picked == m_scene.target(1));
+  mp_followed = ((m_big_ball || (picked == m_scene.target(0))) ? 0 : picked);
+  m_scene.setEvilBigBall(!m_big_ball);
+  return true;
 }
 
 // -------------------------------------------------------------------------
@@ -123,7 +242,7 @@ void GLDemoWidget::tick(int i_ms,
 
 bool GLDemoWidget::jump()
 {
-  const Globject* pt = m_scene.target((m_big_ball ? 1 : 0));
+  const Globject* pt = target();
   if (pt) {
     Vector vel = pt->velocity();
     // we can only jump if the target isn't already jumping or falling
@@ -145,6 +264,99 @@ bool GLDemoWidget::jump()
   return false;
 }
 
+// -------------------------------------------------------------------------
+// loadScene(file) : replace the scene by a scene description file
+//
+// return value : false -> the file can't be loaded
+// -------------------------------------------------------------------------
+
+bool GLDemoWidget::loadScene(const QString& i_file)
+{
+  SceneLoader loader;
+  mp_followed = 0;
+  bool ok = loader.load(i_file, m_scene);
+  if (!ok)
+    qWarning("%s : %s", i_file.toLocal8Bit().constData(),
+             loader.errorString().toLocal8Bit().constData());
+  updateGL();
+  return ok;
+}
+
+bool GLDemoWidget::frameGraph() const
+{
+  return m_frame_graph;
+}
+
+void GLDemoWidget::setFrameGraph(bool i_shown)
+{
+  m_frame_graph = i_shown;
+  updateGL();
+}
+
+// -------------------------------------------------------------------------
+// drawFrameGraph() : how busy each thread was over the last frames
+//
+// notes : one lane per scheduler worker (green), and a last one for the
+//         main thread helping the workers (blue). a full bar means the
+//         thread ran jobs during the whole frame.
+// -------------------------------------------------------------------------
+
+void GLDemoWidget::drawFrameGraph()
+{
+  int threads = m_scheduler.workers() + 1;
+
+  glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT |
+               GL_TRANSFORM_BIT);
+  glDisable(GL_LIGHTING);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // pixel coordinates, from the bottom left corner
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0., width(), 0., height(), -1., 1.);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  glBegin(GL_QUADS);
+  for (int t = 0; t < threads; t++) {
+    double left   = GRAPH_MARGIN;
+    double right  = left + GRAPH_FRAMES * GRAPH_BAR;
+    double top    = height() - GRAPH_MARGIN - t * (GRAPH_LANE + GRAPH_GAP);
+    double bottom = top - GRAPH_LANE;
+
+    glColor4d(0., 0., 0., 0.5);
+    glVertex2d(left,  bottom); glVertex2d(right, bottom);
+    glVertex2d(right, top);    glVertex2d(left,  top);
+
+    if (t < threads - 1) glColor4d(0.2, 0.9, 0.2, 0.9);
+    else                 glColor4d(0.3, 0.6, 1.0, 0.9);
+
+    // oldest frame on the left
+    for (int f = 0; f < GRAPH_FRAMES; f++) {
+      int    frame = (m_busy_frame + f) % GRAPH_FRAMES;
+      float  busy  = m_busy[frame * threads + t];
+      double x = left + f * GRAPH_BAR;
+      double y = bottom + GRAPH_LANE * (busy < 1.f ? busy : 1.f);
+      if (y <= bottom) continue;
+      glVertex2d(x, bottom); glVertex2d(x + GRAPH_BAR, bottom);
+      glVertex2d(x + GRAPH_BAR, y); glVertex2d(x, y);
+    }
+  }
+  glEnd();
+
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  glPopMatrix();
+  glPopAttrib();
+}
+
 // -------------------------------------------------------------------------
 // initializeGL() : initialize the opengl state machine
 // -------------------------------------------------------------------------
@@ -162,6 +374,7 @@ void GLDemoWidget::initializeGL()
   glCullFace(GL_BACK);
 
   // enable auto-normalization of scaled normal vectors
+  // (fixed pipeline only, the lighting shader normalizes on its own)
   glEnable(GL_NORMALIZE);
 
   // enable default lighting
@@ -188,10 +401,13 @@ void GLDemoWidget::resizeGL(int width, int height)
 
 void GLDemoWidget::paintGL()
 {
+  // draw in between the last two scene steps
+  m_scene.beginInterpolation(m_lag / SCENE_STEP);
+
   // camera ------------------------------
   {
     // set the new target position
-    const Globject* pt = m_scene.target((m_big_ball ? 1 : 0));
+    const Globject* pt = target();
     if (pt) {
       // camera will point just a little bit over the target
       Vector target = pt->position();
@@ -210,8 +426,9 @@ void GLDemoWidget::paintGL()
       m_camera.setTarget(target);
     }
 
-    // place the camera
+    // place the camera, only what it sees will be drawn
     m_camera.place();
+    m_scene.cull();
   }
 
   // scene -------------------------------
@@ -220,19 +437,35 @@ void GLDemoWidget::paintGL()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
 
-    // draw the scene
-    m_scene.draw(this); glFlush();
+    // draw the scene (qt may have bound textures and changed the material
+    // since the last frame)
+    Texture::forgetBindings();
+    MaterialRegistry::forgetApplied();
+    LightingShader::begin();
+    m_scene.draw(this);
+    LightingShader::end();
+    if (m_frame_graph) drawFrameGraph();
+    glFlush();
   }
+  m_scene.endInterpolation();
+  m_painted = true;
 }
 
 // -------------------------------------------------------------------------
 // mousePressEvent(e) : mouse button is pressed
 //
-// notes : clicking the widget enable / disable camera control
+// notes : clicking a body follows it, clicking elsewhere enable / disable
+//         camera control
 // -------------------------------------------------------------------------
 
 void GLDemoWidget::mousePressEvent(QMouseEvent* e)
 {
+  // clicking a body : the camera follows it
+  if ((e->button() == Qt::LeftButton) && !m_mouse_grab && follow(e->pos())) {
+    updateGL();
+    return;
+  }
+
   // clicking the widget enable / disable camera control
   if (e->button() == Qt::LeftButton) {
     m_mouse_grab = !m_mouse_grab;
@@ -247,8 +480,12 @@ void GLDemoWidget::mousePressEvent(QMouseEvent* e)
 
   // big ball control - sheep, beware!
   if (e->button() == Qt::RightButton) {
-    m_big_ball = !m_big_ball;
+    m_big_ball  = !m_big_ball;
+    mp_followed = 0;
     m_scene.setEvilBigBall(!m_big_ball);
+
+    // the camera follows another target
+    updateGL();
   }
 }
 
@@ -278,5 +515,8 @@ void GLDemoWidget::mouseMoveEvent(QMouseEvent* e)
         if (degrees < -35.) degrees = -35.;
       m_camera.setTilt(degrees);
     }
+
+    // the scene only redraws itself when something moves
+    updateGL();
   }
 }
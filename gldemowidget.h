@@ -25,8 +25,10 @@ class   GLDemoWidget;
 
 #include "camera.h"
 #include "scene.h"
+#include "scheduler.h"
 #include <QGLWidget>
 #include <QPoint>
+#include <vector>
 
 class GLDemoWidget : public QGLWidget
 //
@@ -37,11 +39,20 @@ class GLDemoWidget : public QGLWidget
   GLDemoWidget(QWidget* parent = 0);
 
   // called at each frame (are up, left, down and right buttons pressed?)
-  void tick(int i_ms, bool i_up, bool i_left, bool i_down, bool i_right);
+  // (true -> the widget was drawn since the last tick)
+  bool tick(double i_sec,
+            bool i_up, bool i_left, bool i_down, bool i_right);
 
   // make the current target jump! (false -> not possible)
   bool jump();
 
+  // replace the scene by a scene description file (see SceneLoader)
+  bool loadScene(const QString& i_file);
+
+  // show how busy each thread was over the last frames
+  bool frameGraph() const;
+  void setFrameGraph(bool i_shown);
+
  protected:
   // standard QGLWidget opengl methods
   virtual void initializeGL();
@@ -52,12 +63,34 @@ class GLDemoWidget : public QGLWidget
   virtual void mousePressEvent(QMouseEvent* e);
   virtual void mouseMoveEvent(QMouseEvent* e);
 
+  // accelerate the current target for 'seconds'
+  void steer(double i_sec, bool i_up, bool i_left, bool i_down, bool i_right);
+
+  // current target (followed by the camera, steered by the buttons)
+  const Globject* target() const;
+
+  // follow the body under the mouse (false -> there is none)
+  bool follow(const QPoint& i_pos);
+
+  // per thread busy bars, over the scene
+  void drawFrameGraph();
+
  private:
+  Scheduler m_scheduler; // steps and culls the scene (before m_scene)
   Scene  m_scene;      // the scene
   Camera m_camera;     // main camera
   bool   m_mouse_grab; // is the mouse grabbed for camera control?
   QPoint m_mouse_pos;  // last mouse position
   bool   m_big_ball;   // true -> target is the big ball
+  const Globject* mp_followed; // target picked with the mouse (0 -> none)
+  bool   m_painted;    // drawn since the last tick?
+  double m_lag;        // time not simulated yet (< one scene step)
+  bool   m_moving;     // did the scene move during the last steps?
+  bool   m_frame_graph;          // show drawFrameGraph?
+  std::vector<double> m_times;   // busy time of each thread (s)
+  std::vector<float>  m_busy;    // busy ratios (frame * threads + thread)
+  int    m_busy_frame;           // next frame in m_busy (oldest one)
+  double m_memory_log;           // time since the memory was logged (s)
 };
 
 #endif // GLDEMOWIDGET_H
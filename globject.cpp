@@ -25,31 +25,32 @@
 #include <QGLWidget>
 #include <QtOpenGL>
 #include <cmath>
+#include "memorystats.h"
 #include <algorithm>
 
 Globject::Globject()
   :mp_transform(0),
    m_velocity(),
    m_movable(false),
+   m_visible(true),
    m_children(),
    mp_containerLimits(0)
 {
   // by default, a globject is not movable
   setMovable(false);
+  MemoryStats::allocated(MemoryStats::GLOBJECT, sizeof(Globject));
 }
 
 Globject::~Globject()
 {
+  MemoryStats::freed(MemoryStats::GLOBJECT, sizeof(Globject));
+
   // free dynamically allocated members
   delete mp_transform;       mp_transform = 0;
   delete mp_containerLimits; mp_containerLimits = 0;
 
   // free all the children
-  for (vec_globject::iterator i = m_children.begin();
-       i != m_children.end(); i++) {
-    delete (*i); (*i) = 0;
-  }
-  m_children.clear();
+  deleteChildren();
 }
 
 // -------------------------------------------------------------------------
@@ -113,10 +114,21 @@ void Globject::setMovable(bool i_movable)
     setVelocity(Vector());
 }
 
+bool Globject::visible() const
+{
+  return m_visible;
+}
+
+void Globject::setVisible(bool i_visible)
+{
+  m_visible = i_visible;
+}
+
 // -------------------------------------------------------------------------
 // (add/remove)child, children() : add, remove child, access children
 //
-// notes                    : children are destroyed with the parent
+// notes                    : children are destroyed with the parent,
+//                            or with deleteChildren()
 // removeChild return value : 'true' if the child was found and removed
 // -------------------------------------------------------------------------
 
@@ -136,6 +148,15 @@ bool Globject::removeChild(const Globject* p)
   else return false;
 }
 
+void Globject::deleteChildren()
+{
+  for (vec_globject::iterator i = m_children.begin();
+       i != m_children.end(); i++) {
+    delete (*i); (*i) = 0;
+  }
+  m_children.clear();
+}
+
 const Globject::vec_globject& Globject::children() const
 {
   return (m_children);
@@ -150,6 +171,8 @@ const Globject::vec_globject& Globject::children() const
 
 void Globject::draw(QGLWidget* i_gl)
 {
+  if (!m_visible) return;
+
   // transformations are applied to this object and all of its children
   if (mp_transform) {
     glPushMatrix();
@@ -213,6 +236,23 @@ BoundingSphere Globject::containerLimits() const
     return globject_boundingSphere();
 }
 
+// -------------------------------------------------------------------------
+// colliders(spheres) : the globject collision shape, if it has one
+//
+// notes : the spheres are appended, children shapes are not included
+// return value : how many spheres were appended
+// -------------------------------------------------------------------------
+
+int Globject::colliders(vec_spheres& o_spheres) const
+{
+  unsigned int first = o_spheres.size();
+  globject_colliders(o_spheres);
+  if (mp_transform)
+    for (unsigned int i = first; i < o_spheres.size(); i++)
+      o_spheres[i].applyTransform(*mp_transform);
+  return (o_spheres.size() - first);
+}
+
 // -------------------------------------------------------------------------
 // setContainerLimits(BoundingSphere) : set the world limits for children
 //
@@ -275,6 +315,13 @@ BoundingSphere Globject::globject_boundingSphere() const
     return BoundingSphere();
 }
 
+void Globject::globject_colliders(vec_spheres& o_spheres) const
+{
+  // -------------------------------------------------------------
+  // by default, the outer bounding sphere is all there is to know
+  // -------------------------------------------------------------
+}
+
 // -------------------------------------------------------------------------
 // introduceTo(Globject, BS, is_container) : make the globject aware of the
 //   existence of another globject. (mostly for collision checking)
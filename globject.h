@@ -60,9 +60,14 @@ class Globject
   bool movable() const;
   void setMovable(bool i_movable);
 
+  // hidden globjects (and their children) are not drawn
+  bool visible() const;
+  void setVisible(bool i_visible);
+
   // add / remove child, child globject is destroyed with the parent
   void addChild(Globject* p);
   bool removeChild(const Globject* p);
+  void deleteChildren();
 
   typedef std::vector<Globject*> vec_globject;
   const vec_globject& children() const;
@@ -78,6 +83,11 @@ class Globject
   BoundingSphere containerLimits() const;
   void setContainerLimits(const BoundingSphere& l);
 
+  // collision shape : a few spheres inside the outer bounding sphere,
+  // tighter than it (in the parent space, none -> the outer sphere)
+  typedef std::vector<BoundingSphere> vec_spheres;
+  int colliders(vec_spheres& o_spheres) const;
+
   // collision / interaction / limits check
   bool introduceTo(Globject& bob, bool is_container = false);
   bool checkLimits(const BoundingSphere& i_limits);
@@ -88,6 +98,9 @@ class Globject
   virtual bool           globject_tick(double i_sec);
   virtual BoundingSphere globject_boundingSphere() const;
 
+  // optional collision shape, in the globject space (see colliders)
+  virtual void globject_colliders(vec_spheres& o_spheres) const;
+
   // general collision checking using bounding spheres
   bool introduceTo(Globject* bob, const BoundingSphere& bsphere_b,
                    bool is_container);
@@ -96,6 +109,7 @@ class Globject
   Transform*      mp_transform;       // TRS transformations (0 if none )
   Vector          m_velocity;         // current velocity    (unit : m/s)
   bool            m_movable;          // moves, is affected by collisions
+  bool            m_visible;          // drawn by draw()
   vec_globject    m_children;
   BoundingSphere* mp_containerLimits; // inner limits for children
 };
@@ -0,0 +1,268 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "lightingshader.h"
+#include "material.h"
+#include <QtOpenGL>
+#include <QGLShaderProgram>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define MATERIALS  16   // entries of the table (the last one is shared)
+
+// the shader is given the same constants
+#define GLSL_STRING(x)  #x
+#define GLSL_DEFINE(x)  "#define " #x " " GLSL_STRING(x) "\n"
+
+static const char* LIGHTING_VERTEX_SHADER =
+  GLSL_DEFINE(MATERIALS)
+  "\n"
+  "uniform vec4 materials[MATERIALS * 4]; // ambient, diffuse, specular\n"
+  "                                       // (shininess : alpha), emission\n"
+  "uniform int  material;                 // entry of the table\n"
+  "\n"
+  "void main()\n"
+  "{\n"
+  "  gl_Position = ftransform();\n"
+  "  gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+  "\n"
+  "  vec4 ambient  = materials[material * 4];\n"
+  "  vec4 diffuse  = materials[material * 4 + 1];\n"
+  "  vec4 specular = materials[material * 4 + 2];\n"
+  "  vec4 emission = materials[material * 4 + 3];\n"
+  "\n"
+  "  // light 0, as the fixed pipeline would do it\n"
+  "  vec4 ec = gl_ModelViewMatrix * gl_Vertex;\n"
+  "  vec3 n  = normalize(gl_NormalMatrix * gl_Normal);\n"
+  "  vec4 lp = gl_LightSource[0].position;\n"
+  "  vec3 l  = normalize(lp.w == 0. ? lp.xyz : lp.xyz - ec.xyz);\n"
+  "  float d = max(dot(n, l), 0.);\n"
+  "  vec4 c  = emission + ambient * gl_LightModel.ambient +\n"
+  "            ambient * gl_LightSource[0].ambient +\n"
+  "            diffuse * gl_LightSource[0].diffuse * d;\n"
+  "  if (d > 0.) {\n"
+  "    float h = max(dot(n, normalize(l + vec3(0., 0., 1.))), 0.);\n"
+  "    c.rgb += specular.rgb * gl_LightSource[0].specular.rgb *\n"
+  "             (specular.a > 0. ? pow(h, specular.a) : 1.);\n"
+  "  }\n"
+  "  c.a = diffuse.a;\n"
+  "  gl_FrontColor = clamp(c, 0., 1.);\n"
+  "}\n";
+
+// the shader, for one opengl context at a time
+static QGLShaderProgram*  sp_program = 0;
+static const QGLContext*  sp_context = 0;
+static int                s_materials_location = -1;
+static int                s_shared_location    = -1; // last entry
+static int                s_material_location  = -1;
+
+// the table of materials (entry 0 : opengl default material)
+static GLfloat s_table[MATERIALS * 4][4] = {
+  { 0.2f, 0.2f, 0.2f, 1.f },
+  { 0.8f, 0.8f, 0.8f, 1.f },
+  { 0.f,  0.f,  0.f,  0.f },
+  { 0.f,  0.f,  0.f,  1.f } };
+static int              s_entries  = 1;     // entries in use
+static bool             s_uploaded = false; // is the table in the shader?
+static int              s_current  = -1;    // selected entry
+static std::vector<int> s_stack;            // see pushMaterial
+static std::vector<int> s_entry_of_id;      // entries of registered
+                                            // materials (-1 : none yet)
+
+bool LightingShader::s_enabled = false;
+bool LightingShader::s_active  = false;
+
+// -------------------------------------------------------------------------
+// setEnabled(enabled) : light in the shader instead of the fixed pipeline
+//
+// notes : if the opengl context can't run the shader, it stays disabled
+//         (see begin)
+// -------------------------------------------------------------------------
+
+void LightingShader::setEnabled(bool i_enabled)
+{
+  s_enabled = i_enabled;
+}
+
+bool LightingShader::enabled()
+{
+  return s_enabled;
+}
+
+// -------------------------------------------------------------------------
+// begin() : bind the shader, lit objects drawn from now on are shaded
+// end()   : release it, back to the fixed pipeline
+// active() : is the shader bound?
+//
+// notes : the default material is selected by begin
+// -------------------------------------------------------------------------
+
+bool LightingShader::begin()
+{
+  if (!s_enabled || s_active) return s_active;
+
+  if (!sp_program || (sp_context != QGLContext::currentContext())) {
+    if (!create()) {
+      s_enabled = false;
+      return false;
+    }
+  }
+
+  sp_program->bind();
+  s_active = true;
+  if (!s_uploaded) {
+    sp_program->setUniformValueArray(s_materials_location, s_table[0],
+                                     MATERIALS * 4, 4);
+    s_uploaded = true;
+  }
+  s_stack.clear();
+  select(0);
+  return true;
+}
+
+bool LightingShader::end()
+{
+  if (!s_active) return false;
+
+  sp_program->release();
+  s_active = false;
+  return true;
+}
+
+bool LightingShader::active()
+{
+  return s_active;
+}
+
+// -------------------------------------------------------------------------
+// setMaterial(material, id) : select the table entry of a material
+// pushMaterial()        : remember the selected entry
+// popMaterial()         : select it back
+// -------------------------------------------------------------------------
+
+void LightingShader::setMaterial(const Material& i_material, int i_id)
+{
+  if (s_active) select(index(i_material, i_id));
+}
+
+void LightingShader::pushMaterial()
+{
+  s_stack.push_back(s_current);
+}
+
+void LightingShader::popMaterial()
+{
+  if (s_stack.empty()) return;
+  if (s_active) select(s_stack.back());
+  s_stack.pop_back();
+}
+
+// -------------------------------------------------------------------------
+// create() : compile the shader in the current opengl context
+// -------------------------------------------------------------------------
+
+bool LightingShader::create()
+{
+  delete sp_program; sp_program = 0;
+  sp_context = 0;
+  s_uploaded = false;
+  s_current  = -1;
+  if (!QGLShaderProgram::hasOpenGLShaderPrograms()) return false;
+
+  sp_program = new QGLShaderProgram;
+  if (!sp_program->addShaderFromSourceCode(QGLShader::Vertex,
+                                           LIGHTING_VERTEX_SHADER) ||
+      !sp_program->link()) {
+    qWarning("lighting shader : %s",
+             sp_program->log().toLocal8Bit().constData());
+    delete sp_program; sp_program = 0;
+    return false;
+  }
+  sp_context = QGLContext::currentContext();
+
+  char shared[32];
+  sprintf(shared, "materials[%d]", (MATERIALS - 1) * 4);
+  s_materials_location = sp_program->uniformLocation("materials");
+  s_shared_location    = sp_program->uniformLocation(shared);
+  s_material_location  = sp_program->uniformLocation("material");
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// index(material, id) : entry of a material, added to the table if needed
+//
+// notes : materials lighting the same way share their entry. once the
+//         table is full, the last entry is rewritten for each material
+//         that isn't in the table (it is never remembered by id).
+// -------------------------------------------------------------------------
+
+int LightingShader::index(const Material& i_material, int i_id)
+{
+  if ((i_id >= 0) && (i_id < (int)s_entry_of_id.size()) &&
+      (s_entry_of_id[i_id] >= 0))
+    return s_entry_of_id[i_id];
+
+  const Color* colors[4] = {
+    &i_material.ambientReflectance(), &i_material.diffuseReflectance(),
+    &i_material.specularReflectance(), &i_material.emission() };
+  GLfloat entry[4][4];
+  for (int i = 0; i < 4; i++)
+    memcpy(entry[i], colors[i]->array(), sizeof(entry[i]));
+  entry[2][3] = i_material.shininess() * 128.f;
+  entry[3][3] = 1.f;
+
+  int i = 0;
+  while ((i < s_entries) && memcmp(s_table[i * 4], entry, sizeof(entry)))
+    i++;
+
+  if ((i == s_entries) && (s_entries < MATERIALS)) {
+    s_entries++;
+    memcpy(s_table[i * 4], entry, sizeof(entry));
+    sp_program->setUniformValueArray(s_materials_location, s_table[0],
+                                     s_entries * 4, 4);
+  }
+
+  if (i < MATERIALS - 1) {
+    if (i_id >= 0) {
+      if (i_id >= (int)s_entry_of_id.size())
+        s_entry_of_id.resize(i_id + 1, -1);
+      s_entry_of_id[i_id] = i;
+    }
+    return i;
+  }
+  if (i < s_entries) return i;
+
+  memcpy(s_table[(MATERIALS - 1) * 4], entry, sizeof(entry));
+  sp_program->setUniformValueArray(s_shared_location, entry[0], 4, 4);
+  return MATERIALS - 1;
+}
+
+// -------------------------------------------------------------------------
+// select(index) : the shader lights with a table entry
+// -------------------------------------------------------------------------
+
+void LightingShader::select(int i_index)
+{
+  if (i_index == s_current) return;
+  s_current = i_index;
+  sp_program->setUniformValue(s_material_location, (GLint)i_index);
+}
@@ -0,0 +1,72 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef LIGHTINGSHADER_H
+#define LIGHTINGSHADER_H
+class   LightingShader;
+
+class Material;
+
+class LightingShader
+//
+// LightingShader : light 0 computed in a vertex shader instead of the
+//                  fixed pipeline, the materials are kept in a table of
+//                  uniforms and selected by their index
+//
+//   - a material is added to the table the first time it is applied,
+//     selecting it afterwards costs one uniform instead of glMaterial
+//     calls and a push of the lighting attributes
+//   - normals are transformed by the normal matrix and normalized in the
+//     shader, GL_NORMALIZE has no effect on the shaded objects
+//   - fragments are left to the fixed pipeline (textures)
+//   - without shader support, the fixed pipeline is used
+//
+{
+ public:
+  // light in the shader (before anything is drawn)
+  static void setEnabled(bool i_enabled);
+  static bool enabled();
+
+  // bind the shader around the lit objects ('true' if it is bound), and
+  // release it ('true' if it was bound)
+  static bool begin();
+  static bool end();
+  static bool active();
+
+  // select the material of the next primitives (see Material), the
+  // entries of the registered materials are found by id
+  // (see MaterialRegistry)
+  static void setMaterial(const Material& i_material, int i_id = -1);
+  static void pushMaterial();
+  static void popMaterial();
+
+ private:
+  LightingShader();
+
+  static bool create();
+  static int  index(const Material& i_material, int i_id);
+  static void select(int i_index);
+
+  static bool s_enabled; // light in the shader?
+  static bool s_active;  // is the shader bound?
+};
+
+#endif // LIGHTINGSHADER_H
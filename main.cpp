@@ -20,15 +20,47 @@
 */
 
 #include "mainwidget.h"
+#include "batch.h"
+#include "renderbench.h"
+#include "sheep.h"
+#include "lightingshader.h"
 #include <QApplication>
-#include <cstdlib>
+#include <QStringList>
 
 int main(int argc, char *argv[])
 {
-  srand(42);
   QApplication app(argc, argv);
+
+  // sheep animated in a vertex shader (before any sheep is created)
+  if (app.arguments().contains("--shader-animation"))
+    Sheep::setShaderAnimation(true);
+
+  // lighting in a vertex shader instead of the fixed pipeline
+  if (app.arguments().contains("--shader-lighting"))
+    LightingShader::setEnabled(true);
+
+  // batch simulation : no window, results are written as csv
+  Batch batch;
+  if (batch.parseArguments(app.arguments())) return batch.run();
+
+  // offscreen render benchmark : no window, frame times are reported
+  RenderBench render_bench;
+  if (render_bench.parseArguments(app.arguments())) return render_bench.run();
+
   MainWidget main_win;
   main_win.setWindowTitle(main_win.tr("Shaolin Sheep"));
+
+  // scene description file (--scene FILE)
+  QStringList args = app.arguments();
+  int scene_arg = args.indexOf("--scene");
+  if ((scene_arg > 0) && (scene_arg + 1 < args.size()))
+    if (!main_win.loadScene(args.at(scene_arg + 1))) return 1;
+
+  // frame rate (--fps N, 60 by default)
+  int fps_arg = args.indexOf("--fps");
+  if ((fps_arg > 0) && (fps_arg + 1 < args.size()))
+    main_win.setFrameRate(args.at(fps_arg + 1).toInt());
+
   main_win.show();
   return app.exec();
 }
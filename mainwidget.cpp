@@ -30,15 +30,25 @@
 #include <QHBoxLayout>
 #include <QKeyEvent>
 
-#define DEMO_FPS       60
-#define TICK_INTERVAL (1000 / DEMO_FPS)
+#define DEMO_FPS       60    // default frame rate (see setFrameRate)
+#define NS_PER_SECOND  1000000000LL
+#define NS_PER_MS      1000000LL
+
+// when the scene is at rest, it is ticked less often
+#define IDLE_FPS       5
+#define IDLE_DELAY     1.    // seconds at rest before slowing down
 
 MainWidget::MainWidget(QWidget* parent)
   :QWidget(parent),
    mp_glwidget(0),
    mp_box(0),
    mp_timer(0),
-   m_tick_timer(),
+   m_clock(),
+   m_last_frame(0),
+   m_next_frame(0),
+   m_fps(DEMO_FPS),
+   m_idle(false),
+   m_rest(0.),
    mp_fps_timer(0),
    m_current_fps(0),
    m_fps_counter(0)
@@ -107,9 +117,10 @@ MainWidget::MainWidget(QWidget* parent)
 
   // initialize main application timer
   mp_timer = new QTimer;
+  mp_timer->setSingleShot(true);
   connect(mp_timer, SIGNAL(timeout()), this, SLOT(tick()));
-  mp_timer->start(TICK_INTERVAL);
-  m_tick_timer.start();
+  m_clock.start();
+  mp_timer->start(0);
 
   // initialize 'frame per second' timer
   mp_fps_timer = new QTimer;
@@ -125,18 +136,81 @@ MainWidget::~MainWidget()
   delete mp_fps_timer;    mp_fps_timer  = 0;
 }
 
+bool MainWidget::loadScene(const QString& i_file)
+{
+  return (mp_glwidget ? mp_glwidget->loadScene(i_file) : false);
+}
+
+// -------------------------------------------------------------------------
+// setFrameRate(fps) : how many frames per second to draw (at most)
+// -------------------------------------------------------------------------
+
+void MainWidget::setFrameRate(int i_fps)
+{
+  m_fps = (i_fps > 0 ? i_fps : DEMO_FPS);
+}
+
+// -------------------------------------------------------------------------
+// tick() : animate the scene, at a low rate while nothing is moving
+//
+// notes : frames are paced on a monotonic nanosecond clock. the timer
+//         only has a millisecond precision, so it is started again for
+//         each frame, with the time left until the next frame deadline.
+//         deadlines are 1/fps apart, whatever the time a frame takes,
+//         except when the frames are late (there is no catching up).
+//
+//         the scene is only drawn when something visible changed. after
+//         IDLE_DELAY seconds without drawing (and no button down), the
+//         frame rate drops to IDLE_FPS, until something moves again.
+// -------------------------------------------------------------------------
+
 void MainWidget::tick()
 {
-  if (mp_glwidget)
-    // each tick asks for a new frame
-    mp_glwidget->tick(m_tick_timer.restart(),
-                      mp_buttons[0] && mp_buttons[0]->isDown(),
-                      mp_buttons[1] && mp_buttons[1]->isDown(),
-                      mp_buttons[2] && mp_buttons[2]->isDown(),
-                      mp_buttons[3] && mp_buttons[3]->isDown());
+  // woken up too early?
+  qint64 now = m_clock.nsecsElapsed();
+  if (m_next_frame - now > NS_PER_MS) {
+    mp_timer->start((int)((m_next_frame - now) / NS_PER_MS));
+    return;
+  }
+  double sec = (double)(now - m_last_frame) / NS_PER_SECOND;
+  m_last_frame = now;
+
+  bool down[4];
+  bool input = false;
+  for (int i=0; i<4; i++) {
+    down[i] = mp_buttons[i] && mp_buttons[i]->isDown();
+    if (down[i]) input = true;
+  }
+
+  // each tick may ask for a new frame
+  bool drawn = mp_glwidget &&
+    mp_glwidget->tick(sec, down[0], down[1], down[2], down[3]);
 
   // a new frame has been drawn
-  m_fps_counter++;
+  if (drawn) m_fps_counter++;
+
+  if (drawn || input) { m_rest = 0.; m_idle = false; }
+  else {
+    m_rest += sec;
+    if (m_rest >= IDLE_DELAY) m_idle = true;
+  }
+
+  // next frame deadline
+  qint64 period = NS_PER_SECOND / (m_idle ? IDLE_FPS : m_fps);
+  m_next_frame += period;
+  if (m_next_frame < now) m_next_frame = now + period;
+  mp_timer->start((int)((m_next_frame - m_clock.nsecsElapsed()) / NS_PER_MS));
+}
+
+void MainWidget::wakeUp()
+{
+  m_rest = 0.;
+  if (m_idle) {
+    // the next frame is drawn right away
+    m_idle = false;
+    m_next_frame = m_clock.nsecsElapsed();
+    mp_timer->start(0);
+  }
 }
 
 void MainWidget::fps_tick()
@@ -160,8 +234,14 @@ void MainWidget::keyPressEvent(QKeyEvent* e)
       mp_glwidget->jump();
       ignore = false;
     }
+    if (mp_glwidget && (e->key() == Qt::Key_G)) {
+      // how busy are the threads?
+      mp_glwidget->setFrameGraph(!mp_glwidget->frameGraph());
+      ignore = false;
+    }
   }
   if (ignore) e->ignore();
+  else wakeUp();
 }
 
 void MainWidget::keyReleaseEvent(QKeyEvent* e)
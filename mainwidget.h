@@ -27,8 +27,9 @@ class GLDemoWidget;
 class QTimer;
 class QGroupBox;
 class QPushButton;
+class QString;
 #include <QWidget>
-#include <QTime>
+#include <QElapsedTimer>
 
 class MainWidget : public QWidget
 //
@@ -41,6 +42,12 @@ class MainWidget : public QWidget
   MainWidget(QWidget* parent = 0);
   virtual ~MainWidget();
 
+  // replace the scene by a scene description file (see SceneLoader)
+  bool loadScene(const QString& i_file);
+
+  // how many frames per second to draw, at most (default : 60)
+  void setFrameRate(int i_fps);
+
  protected slots:
   void tick();      // tick at each frame
   void fps_tick();  // tick at each second to update current fps rate
@@ -50,12 +57,18 @@ class MainWidget : public QWidget
   virtual void keyReleaseEvent(QKeyEvent* e);
 
   bool setButtonState(int i_key, bool i_down);
+  void wakeUp();    // back to the full tick rate
 
  private:
   GLDemoWidget* mp_glwidget;       // main opengl widget
   QGroupBox*    mp_box;            // group box that holds mp_glwidget
   QTimer*       mp_timer;          // main application timer
-  QTime         m_tick_timer;      // keeps time elapsed since last tick
+  QElapsedTimer m_clock;           // monotonic clock, for frame pacing
+  qint64        m_last_frame;      // when was the last frame (ns)
+  qint64        m_next_frame;      // when is the next frame due (ns)
+  int           m_fps;             // frame rate when the scene moves
+  bool          m_idle;            // scene at rest, lower frame rate
+  double        m_rest;            // time spent without drawing (s)
   QTimer*       mp_fps_timer;      // 'frame per second' timer
   int           m_current_fps;     // current 'frame per second' rate
   int           m_fps_counter;     // frames displayed since last check
@@ -20,6 +20,8 @@
 */
 
 #include "material.h"
+#include "memorystats.h"
+#include "lightingshader.h"
 #include <QtOpenGL>
 
 Material::Material(const Color& ambient_and_diffuse)
@@ -29,34 +31,72 @@ Material::Material(const Color& ambient_and_diffuse)
     m_shininess(0.),
     mp_emission(0)
 {
+  MemoryStats::allocated(MemoryStats::MATERIAL, sizeof(Material));
 }
 
+Material::Material(const Color& ambient, const Color& diffuse)
+  : m_ambient(ambient),
+    m_diffuse(diffuse),
+    mp_specular(0),
+    m_shininess(0.),
+    mp_emission(0)
+{
+  MemoryStats::allocated(MemoryStats::MATERIAL, sizeof(Material));
+}
+
+Material::Material(const Material& m)
+  : m_ambient(m.m_ambient),
+    m_diffuse(m.m_diffuse),
+    mp_specular(m.mp_specular),
+    m_shininess(m.m_shininess),
+    mp_emission(m.mp_emission)
+{
+  MemoryStats::allocated(MemoryStats::MATERIAL, sizeof(Material));
+}
+
+Material::~Material()
+{
+  MemoryStats::freed(MemoryStats::MATERIAL, sizeof(Material));
+}
+
+// -------------------------------------------------------------------------
+// pushAttrib() : save the current material
+// apply()      : make it the current material
+// popAttrib()  : restore the saved material
+//
+// notes : with the lighting shader bound, the material is an entry of its
+//         table (see LightingShader), the opengl states are left alone
+// -------------------------------------------------------------------------
+
 void Material::pushAttrib()
 {
-  glPushAttrib(GL_CURRENT_BIT | GL_LIGHTING_BIT);
+  if (LightingShader::active()) LightingShader::pushMaterial();
+  else glPushAttrib(GL_CURRENT_BIT | GL_LIGHTING_BIT);
 }
 
 void Material::apply() const
 {
+  if (LightingShader::active()) {
+    LightingShader::setMaterial(*this);
+    return;
+  }
+
   // ambient and diffuse reflectance
   glMaterialfv(GL_FRONT, GL_AMBIENT, m_ambient.array());
   glMaterialfv(GL_FRONT, GL_DIFFUSE, m_diffuse.array());
   glColor4fv(m_diffuse.array());
 
-  // specular reflectance
-  if (mp_specular) {
-    glMaterialfv(GL_FRONT, GL_SPECULAR,  mp_specular->array());
-    glMaterialf (GL_FRONT, GL_SHININESS, m_shininess * 128.);
-  }
-
-  // emission
-  if (mp_emission)
-    glMaterialfv(GL_FRONT, GL_EMISSION,  mp_emission->array());
+  // specular reflectance and emission, none if not given (the material
+  // applied before may have had some, see MaterialRegistry::apply)
+  glMaterialfv(GL_FRONT, GL_SPECULAR,  specularReflectance().array());
+  glMaterialf (GL_FRONT, GL_SHININESS, m_shininess * 128.);
+  glMaterialfv(GL_FRONT, GL_EMISSION,  emission().array());
 }
 
 void Material::popAttrib()
 {
-  glPopAttrib();
+  if (LightingShader::active()) LightingShader::popMaterial();
+  else glPopAttrib();
 }
 
 const Color& Material::ambientReflectance() const
@@ -29,6 +29,9 @@ class Material
 {
  public:
   Material(const Color& ambient_and_diffuse);
+  Material(const Color& ambient, const Color& diffuse);
+  Material(const Material& m);
+  ~Material();
 
   static void pushAttrib();
   void apply() const;
@@ -0,0 +1,132 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "materialregistry.h"
+#include "material.h"
+#include "lightingshader.h"
+#include "memorystats.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <new>
+
+#define CHUNK_SIZE  64    // materials in a chunk of the table
+#define CHUNKS      1024  // chunks at most
+
+const MaterialRegistry::Id MaterialRegistry::NONE;
+
+// -------------------------------------------------------------------------
+// the table : chunks of contiguous materials, allocated as needed and
+// never moved nor deleted, so the materials can be read without locking.
+// the lock is only taken to add materials, the size is published once
+// the new material is written.
+// -------------------------------------------------------------------------
+
+static Material*  s_chunks[CHUNKS]; // zero before anything runs
+static QAtomicInt s_size;           // materials in the table
+
+static QMutex& tableMutex()
+{
+  static QMutex mutex;
+  return mutex;
+}
+
+static inline Material& entry(MaterialRegistry::Id i_id)
+{
+  return s_chunks[i_id / CHUNK_SIZE][i_id % CHUNK_SIZE];
+}
+
+// the material last applied (opengl thread only, see apply)
+static MaterialRegistry::Id s_applied = MaterialRegistry::NONE;
+
+// -------------------------------------------------------------------------
+// intern(material) : id of a material, added to the table if needed
+//
+// notes : when the table is full, NONE is returned (the opengl default
+//         material is used instead)
+// -------------------------------------------------------------------------
+
+MaterialRegistry::Id MaterialRegistry::intern(const Material& i_material)
+{
+  QMutexLocker lock(&tableMutex());
+  int size = (int)s_size;
+  for (Id i = 0; i < size; i++)
+    if (entry(i) == i_material) return i;
+
+  if (size == CHUNKS * CHUNK_SIZE) {
+    qWarning("material registry : too many materials");
+    return NONE;
+  }
+  if (!s_chunks[size / CHUNK_SIZE])
+    s_chunks[size / CHUNK_SIZE] =
+      (Material*)::operator new(CHUNK_SIZE * sizeof(Material));
+  new (&entry(size)) Material(i_material);
+
+  // kept for the whole process, they are accounted apart from the
+  // materials that can leak
+  MemoryStats::freed(MemoryStats::MATERIAL, sizeof(Material));
+  MemoryStats::allocated(MemoryStats::REGISTERED, sizeof(Material));
+
+  s_size.fetchAndStoreRelease(size + 1);
+  return size;
+}
+
+const Material& MaterialRegistry::material(Id i_id)
+{
+  return entry(i_id);
+}
+
+// -------------------------------------------------------------------------
+// apply(id)       : make the material of an id the current material
+// forgetApplied() : the opengl material may have changed
+//
+// notes : applying the material already applied does nothing. NONE
+//         applies the opengl default material. the lighting shader
+//         knows its table entries by id.
+// -------------------------------------------------------------------------
+
+void MaterialRegistry::apply(Id i_id)
+{
+  if (i_id == NONE) {
+    static const Id DEFAULT =
+      intern(Material(Color(0.2, 0.2, 0.2), Color(0.8, 0.8, 0.8)));
+    i_id = DEFAULT;
+    if (i_id == NONE) return;
+  }
+
+  if (LightingShader::active()) {
+    LightingShader::setMaterial(entry(i_id), i_id);
+    return;
+  }
+  if (i_id == s_applied) return;
+  entry(i_id).apply();
+  s_applied = i_id;
+}
+
+void MaterialRegistry::forgetApplied()
+{
+  s_applied = NONE;
+}
+
+int MaterialRegistry::size()
+{
+  return (int)s_size;
+}
@@ -0,0 +1,64 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef MATERIALREGISTRY_H
+#define MATERIALREGISTRY_H
+class   MaterialRegistry;
+
+class Material;
+
+class MaterialRegistry
+//
+// MaterialRegistry : the materials of the process, each one stored once
+//                    in a table and known by its index (id)
+//
+//   - identical materials get the same id, so materials are compared by
+//     their ids
+//   - materials are never removed : models share a few materials, they
+//     are kept for the whole process
+//   - any thread may add materials, reading them doesn't lock
+//
+{
+ public:
+  typedef int Id;
+  static const Id NONE = -1; // no material
+
+  // id of a material, added to the table if it isn't in it yet
+  static Id intern(const Material& i_material);
+
+  // the material of an id
+  static const Material& material(Id i_id);
+
+  // make the material of an id the current opengl material (NONE : the
+  // default material), unless it already is (opengl thread only)
+  static void apply(Id i_id);
+
+  // the opengl material changed behind our back (at the start of a frame)
+  static void forgetApplied();
+
+  // materials in the table
+  static int size();
+
+ private:
+  MaterialRegistry();
+};
+
+#endif // MATERIALREGISTRY_H
@@ -67,6 +67,12 @@ void Matrix::set(double m00, double m01, double m02, double m03,
   *(p++) = m30; *(p++) = m31; *(p++) = m32; *(p++) = m33;
 }
 
+void Matrix::set(const double* i_array)
+{
+  double* p = (double*)mp;
+  for (int i = 0; i < (N*N); i++) p[i] = i_array[i];
+}
+
 void Matrix::transpose()
 {
   double t;
@@ -43,6 +43,7 @@ class Matrix
            double m10, double m11, double m12, double m13,
            double m20, double m21, double m22, double m23,
            double m30, double m31, double m32, double m33);
+  void set(const double* i_array);
 
   void transpose();
 
@@ -0,0 +1,167 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "memorystats.h"
+#include <QAtomicInt>
+#include <cstring>
+
+// -------------------------------------------------------------------------
+// the process counters : objects may be created before any constructor
+// runs (static objects) and by any thread. the counters are atomic, so
+// accounting for an object never takes a lock.
+// -------------------------------------------------------------------------
+
+struct Counters
+{
+  QBasicAtomicInt objects[MemoryStats::TYPES];
+  QBasicAtomicInt bytes[MemoryStats::TYPES];
+  QBasicAtomicInt peak_objects[MemoryStats::TYPES];
+  QBasicAtomicInt peak_bytes[MemoryStats::TYPES];
+  QBasicAtomicInt total;
+  QBasicAtomicInt peak_total;
+};
+
+static Counters s_counters;  // zero before anything runs
+
+// -------------------------------------------------------------------------
+// raise(peak, value) : keep the larger of the two in 'peak'
+//
+// notes : every value a counter takes is seen by the thread that made
+//         it, so the peaks are exact
+// -------------------------------------------------------------------------
+
+static void raise(QBasicAtomicInt& io_peak, int i_value)
+{
+  int peak = io_peak;
+  while ((i_value > peak) && !io_peak.testAndSetRelaxed(peak, i_value))
+    peak = io_peak;
+}
+
+MemoryStats::MemoryStats()
+{
+  memset(m_objects,      0, sizeof(m_objects));
+  memset(m_bytes,        0, sizeof(m_bytes));
+  memset(m_peak_objects, 0, sizeof(m_peak_objects));
+  memset(m_peak_bytes,   0, sizeof(m_peak_bytes));
+  m_total = 0;
+  m_peak_total = 0;
+}
+
+// -------------------------------------------------------------------------
+// current() : the counters as of now
+//
+// notes : the counters are read one by one, while other threads keep
+//         on accounting : the types may not all be read at the same time
+// -------------------------------------------------------------------------
+
+MemoryStats MemoryStats::current()
+{
+  MemoryStats res;
+  const Counters& c = s_counters;
+  for (int t = 0; t < TYPES; t++) {
+    res.m_objects[t]      = c.objects[t];
+    res.m_bytes[t]        = c.bytes[t];
+    res.m_peak_objects[t] = c.peak_objects[t];
+    res.m_peak_bytes[t]   = c.peak_bytes[t];
+  }
+  res.m_total      = c.total;
+  res.m_peak_total = c.peak_total;
+  return res;
+}
+
+// -------------------------------------------------------------------------
+// allocated(type, bytes), freed(type, bytes) : one object more / less
+// -------------------------------------------------------------------------
+
+void MemoryStats::allocated(Type i_type, qint64 i_bytes)
+{
+  Counters& c = s_counters;
+  int bytes = (int)i_bytes;
+  raise(c.peak_objects[i_type], c.objects[i_type].fetchAndAddRelaxed(1) + 1);
+  raise(c.peak_bytes[i_type],
+        c.bytes[i_type].fetchAndAddRelaxed(bytes) + bytes);
+  raise(c.peak_total, c.total.fetchAndAddRelaxed(bytes) + bytes);
+}
+
+void MemoryStats::freed(Type i_type, qint64 i_bytes)
+{
+  Counters& c = s_counters;
+  int bytes = (int)i_bytes;
+  c.objects[i_type].fetchAndAddRelaxed(-1);
+  c.bytes[i_type].fetchAndAddRelaxed(-bytes);
+  c.total.fetchAndAddRelaxed(-bytes);
+}
+
+qint64 MemoryStats::objects(Type i_type) const
+{
+  return m_objects[i_type];
+}
+
+qint64 MemoryStats::bytes(Type i_type) const
+{
+  return m_bytes[i_type];
+}
+
+qint64 MemoryStats::peakObjects(Type i_type) const
+{
+  return m_peak_objects[i_type];
+}
+
+qint64 MemoryStats::peakBytes(Type i_type) const
+{
+  return m_peak_bytes[i_type];
+}
+
+qint64 MemoryStats::totalBytes() const
+{
+  return m_total;
+}
+
+qint64 MemoryStats::peakTotalBytes() const
+{
+  return m_peak_total;
+}
+
+const char* MemoryStats::name(Type i_type)
+{
+  static const char* NAMES[TYPES] = {
+    "globject", "transform", "material", "registered", "quadric", "pixmap",
+    "gpu_texture", "gpu_buffer" };
+  return NAMES[i_type];
+}
+
+// -------------------------------------------------------------------------
+// toString() : "total 1234 KB (peak 1300 KB), globject 812 (25 KB, peak
+//               820), ..." (types without any object are left out)
+// -------------------------------------------------------------------------
+
+QString MemoryStats::toString() const
+{
+  QString res = QString("total %1 KB (peak %2 KB)")
+    .arg(m_total / 1024).arg(m_peak_total / 1024);
+  for (int t = 0; t < TYPES; t++) {
+    if (m_peak_objects[t] == 0) continue;
+    res += QString(", %1 %2 (%3 KB, peak %4)")
+      .arg(name((Type)t)).arg(m_objects[t]).arg(m_bytes[t] / 1024)
+      .arg(m_peak_objects[t]);
+  }
+  return res;
+}
@@ -0,0 +1,89 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+class   MemoryStats;
+
+#include <QString>
+#include <QtGlobal>
+
+class MemoryStats
+//
+// MemoryStats : live objects and bytes of the memory hungry types, and
+//               the most there ever were (for the whole process)
+//
+//   - the types account for themselves as they are created and destroyed
+//   - bytes are the objects own size (the base class size for globjects),
+//     their images, and their opengl textures and buffers (as allocated,
+//     the driver copies are not known)
+//   - GLU quadrics are opaque, only their number is known
+//   - the counters are 32 bits atomic integers : up to 2 GB of each
+//     type, and in total
+//
+{
+ public:
+  enum Type {
+    GLOBJECT,     // Globject (any kind)
+    TRANSFORM,    // Transform
+    MATERIAL,     // Material
+    REGISTERED,   // Material kept by the MaterialRegistry (never freed)
+    QUADRIC,      // GLUquadric
+    PIXMAP,       // texture images (QPixmap)
+    GPU_TEXTURE,  // texture images, on the gpu
+    GPU_BUFFER,   // vertex buffers, on the gpu
+    TYPES
+  };
+
+  MemoryStats();
+
+  // the counters as of now
+  static MemoryStats current();
+
+  // accounting, by the types themselves
+  static void allocated(Type i_type, qint64 i_bytes);
+  static void freed(Type i_type, qint64 i_bytes);
+
+  // live objects and bytes, and the most there were at once
+  qint64 objects(Type i_type) const;
+  qint64 bytes(Type i_type) const;
+  qint64 peakObjects(Type i_type) const;
+  qint64 peakBytes(Type i_type) const;
+
+  // all the types together
+  qint64 totalBytes() const;
+  qint64 peakTotalBytes() const;
+
+  static const char* name(Type i_type);
+
+  // one line, for the logs
+  QString toString() const;
+
+ private:
+  qint64 m_objects[TYPES];
+  qint64 m_bytes[TYPES];
+  qint64 m_peak_objects[TYPES];
+  qint64 m_peak_bytes[TYPES];
+  qint64 m_total;
+  qint64 m_peak_total;
+};
+
+#endif // MEMORYSTATS_H
@@ -23,27 +23,90 @@
 #include "globject.h"
 #include "vector.h"
 #include "boundingsphere.h"
+#include "scheduler.h"
+#include "contactsolver.h"
+
+// fewer objects are not worth a job
+#define OBJECTS_PER_JOB 64
+
+// -------------------------------------------------------------------------
+// Movement : gravity, friction and movement of a range of children
+// -------------------------------------------------------------------------
+
+class Movement : public Loop
+{
+ public:
+  Movement(const Globject::vec_globject& i_objects, double i_sec)
+    :Loop(), m_objects(i_objects), m_sec(i_sec), m_moved(i_objects.size(), 0)
+  {}
+
+  virtual void run(int i_begin, int i_end);
+
+  // did any child move?
+  bool moved() const
+  {
+    for (unsigned int i = 0; i < m_moved.size(); i++)
+      if (m_moved[i]) return true;
+    return false;
+  }
+
+ private:
+  const Globject::vec_globject& m_objects;
+  double                        m_sec;
+  std::vector<char>             m_moved;  // one flag per child
+};
+
+void Movement::run(int i_begin, int i_end)
+{
+  // gravitational acceleration
+  static const Vector G(0., -9.8, 0.);
+
+  // velocity loss due to friction, etc. : 20% per second
+  static const double FRICTION = 0.20;
+
+  for (int i = i_begin; i < i_end; i++) {
+    Globject* o = m_objects[i];
+    if (o->movable()) {
+      // friction
+      o->setVelocity(o->velocity() * (1. - (FRICTION * m_sec)));
+
+      // gravity
+      o->setVelocity(o->velocity() + (G * m_sec));
+
+      // movement / animation
+      if (o->tick(m_sec)) m_moved[i] = 1;
+    }
+  }
+}
+
+Physics::Moved::~Moved()
+{
+}
 
 // -------------------------------------------------------------------------
 // tick(seconds, container) : apply simple physics to container's children
 //
 // seconds   : time elapsed since last tick (in seconds)
 // container : globject holding the objects to which the physics will apply
+// contacts  : if non-null, collisions between children are appended to it
+// moved     : if non-null, told after each movement step, before the
+//             collision check (to finish the animation of the children)
+// scheduler : if non-null, the children are moved by all its threads
+//             (the collisions are still checked in order, on this one)
+// solver    : if non-null, solves the collisions (masses, restitution,
+//             friction), instead of introducing the children to each other
 // return value : 'true' if a change occured
 // -------------------------------------------------------------------------
 
-bool Physics::tick(double i_sec, Globject& i_container)
+bool Physics::tick(double i_sec, Globject& i_container,
+                   vec_contacts* o_contacts, Moved* i_moved,
+                   Scheduler* i_scheduler, ContactSolver* i_solver)
 {
   // physics will be calculated for each 1/1000 of a second
   // (this value must match the longest time spent in one
   //  iteration of the 'while' loop. the worst case)
   static const double CALCULATION_TIME = 0.050;
 
-  // gravitational acceleration
-  static const Vector G(0., -9.8, 0.);
-
-  // velocity loss due to friction, etc. : 20% per second
-  static const double FRICTION = 0.20;
   bool res = false;
 
   double time_left = i_sec;
@@ -56,26 +119,28 @@ bool Physics::tick(double i_sec, Globject& i_container)
     time_left -= delta_t;
 
     // gravity + movement
-    for (Globject::vec_globject::const_iterator it = objs.begin();
-         it != objs.end(); it++) {
-      if ((*it)->movable()) {
-        // friction
-        (*it)->setVelocity((*it)->velocity() * (1. - (FRICTION * delta_t)));
-
-        // gravity
-        (*it)->setVelocity((*it)->velocity() + (G * delta_t));
-
-        // movement / animation
-        if ((*it)->tick(delta_t)) res = true;
-      }
-    }
+    Movement movement(objs, delta_t);
+    if (i_scheduler)
+      i_scheduler->parallelFor(objs.size(), movement, OBJECTS_PER_JOB);
+    else
+      movement.run(0, objs.size());
+    if (movement.moved()) res = true;
+    if (i_moved) i_moved->moved();
 
     // collision check
-    for (unsigned int i = 0; i < objs.size(); i++) {
-      if (objs[i]->checkLimits(limits)) res = true;
-
-      for (unsigned int j = i + 1; j < objs.size(); j++) {
-        if (objs[i]->introduceTo(*(objs[j]))) res = true;
+    if (i_solver) {
+      if (i_solver->solve(objs, limits, o_contacts)) res = true;
+    }
+    else {
+      for (unsigned int i = 0; i < objs.size(); i++) {
+        if (objs[i]->checkLimits(limits)) res = true;
+
+        for (unsigned int j = i + 1; j < objs.size(); j++) {
+          if (objs[i]->introduceTo(*(objs[j]))) {
+            res = true;
+            if (o_contacts) o_contacts->push_back(Contact(objs[i], objs[j]));
+          }
+        }
       }
     }
   }
@@ -23,7 +23,11 @@
 #define PHYSICS_H
 class   Physics;
 
+class ContactSolver;
 class Globject;
+class Scheduler;
+#include <utility>
+#include <vector>
 
 class Physics
 //
@@ -31,8 +35,26 @@ class Physics
 //
 {
  public:
+  // pairs of children that collided
+  typedef std::pair<Globject*, Globject*> Contact;
+  typedef std::vector<Contact>            vec_contacts;
+
+  class Moved
+  //
+  // Moved : told after each movement step of tick(), before the
+  //         collision check
+  //
+  {
+   public:
+    virtual ~Moved();
+    virtual void moved() = 0;
+  };
+
   // apply simple physics to i_container's children
-  static bool tick(double i_sec, Globject& i_container);
+  static bool tick(double i_sec, Globject& i_container,
+                   vec_contacts* o_contacts = 0, Moved* i_moved = 0,
+                   Scheduler* i_scheduler = 0,
+                   ContactSolver* i_solver = 0);
 };
 
 #endif // PHYSICS_H
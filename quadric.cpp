@@ -22,6 +22,7 @@
 #include "quadric.h"
 #include "texture.h"
 #include "material.h"
+#include "memorystats.h"
 #include <QtOpenGL>
 #include <QGLWidget>
 
@@ -29,10 +30,11 @@
 
 Quadric::Quadric()
   :mp_texture(0),
-   mp_material(0),
+   m_material(MaterialRegistry::NONE),
    mp_quadric(gluNewQuadric()),
    m_slices(DEFAULT_SLICES)
 {
+  if (mp_quadric) MemoryStats::allocated(MemoryStats::QUADRIC, 0);
   setOutsideIn(false);
 }
 
@@ -41,9 +43,8 @@ Quadric::~Quadric()
   if (mp_quadric) {
     gluDeleteQuadric(mp_quadric);
     mp_quadric = 0;
+    MemoryStats::freed(MemoryStats::QUADRIC, 0);
   }
-
-  delete mp_material; mp_material = 0;
 }
 
 void Quadric::setOutsideIn(bool i_outside_in)
@@ -66,12 +67,19 @@ void Quadric::setTexture(Texture* i_texture)
   }
 }
 
+// -------------------------------------------------------------------------
+// setMaterial(material) : apply a material (see MaterialRegistry)
+// setMaterial(id)       : apply a registered material
+// -------------------------------------------------------------------------
+
 void Quadric::setMaterial(const Material& i_material)
 {
-  if ((mp_material == 0) || !(*mp_material == i_material)) {
-    delete mp_material;
-    mp_material = new Material(i_material);
-  }
+  m_material = MaterialRegistry::intern(i_material);
+}
+
+void Quadric::setMaterial(MaterialRegistry::Id i_material)
+{
+  m_material = i_material;
 }
 
 bool Quadric::setSlices(int i_slices)
@@ -93,9 +101,14 @@ Texture* Quadric::texture()
   return mp_texture;
 }
 
-const Material* Quadric::material()
+MaterialRegistry::Id Quadric::material() const
 {
-  return mp_material;
+  return m_material;
+}
+
+void Quadric::drawShape(QGLWidget* i_gl)
+{
+  globject_draw(i_gl);
 }
 
 void Quadric::globject_draw(QGLWidget* i_gl)
@@ -106,17 +119,13 @@ void Quadric::globject_draw(QGLWidget* i_gl)
     mp_texture->bind(i_gl);
   }
 
-  if (mp_material) {
-    // apply material
-    Material::pushAttrib();
-    mp_material->apply();
-  }
+  // apply material (the default one if none), unless already applied
+  MaterialRegistry::apply(m_material);
 
   if (mp_quadric)
     // draw quadric
     drawQuadric(mp_quadric);
 
   // restore previous state
-  if (mp_material) Material::popAttrib();
   if (mp_texture ) Texture::popAttrib();
 }
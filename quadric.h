@@ -28,6 +28,7 @@ class Material;
 class GLUquadric;
 
 #include "globject.h"
+#include "materialregistry.h"
 
 class Quadric : public Globject
 //
@@ -42,14 +43,19 @@ class Quadric : public Globject
   void setWireFrame(bool i_wireframe);
   void setTexture(Texture* i_texture);
   void setMaterial(const Material& i_material);
+  void setMaterial(MaterialRegistry::Id i_material);
 
   // subdivision settings
   bool setSlices(int i_slices);
   int  slices() const;
 
-  // Texture* and Material* are null if none applied
+  // Texture* is null and the material is NONE if none applied
   Texture* texture();
-  const Material* material();
+  MaterialRegistry::Id material() const;
+
+  // draw the quadric alone : no transform and no children
+  // (the caller has already set the opengl transformations)
+  void drawShape(QGLWidget* i_gl);
 
  protected:
   virtual void globject_draw(QGLWidget* i_gl);
@@ -57,7 +63,7 @@ class Quadric : public Globject
 
  private:
   Texture*    mp_texture;  // null if none applied
-  Material*   mp_material; // null if none applied
+  MaterialRegistry::Id m_material; // NONE if none applied
   GLUquadric* mp_quadric;
   int         m_slices;    // slices (number of subdivisions)
 };
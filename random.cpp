@@ -0,0 +1,120 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "random.h"
+
+#define PCG_MULTIPLIER Q_UINT64_C(6364136223846793005)
+
+Random::Random(quint64 i_seed, quint64 i_stream)
+  :m_state(0),
+   m_inc(1),
+   m_splits(0)
+{
+  seed(i_seed, i_stream);
+}
+
+// -------------------------------------------------------------------------
+// seed(seed, stream) : restart the sequence
+//
+// notes : this is the standard pcg32 initialisation
+// -------------------------------------------------------------------------
+
+void Random::seed(quint64 i_seed, quint64 i_stream)
+{
+  m_state  = 0;
+  m_inc    = (i_stream << 1) | 1;
+  m_splits = 0;
+  next();
+  m_state += i_seed;
+  next();
+}
+
+// -------------------------------------------------------------------------
+// next() : uniform 32 bits value (pcg32 xsh-rr output function)
+// -------------------------------------------------------------------------
+
+quint32 Random::next()
+{
+  quint64 old = m_state;
+  m_state = old * PCG_MULTIPLIER + m_inc;
+
+  quint32 xorshifted = (quint32)(((old >> 18) ^ old) >> 27);
+  quint32 rot        = (quint32)(old >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// -------------------------------------------------------------------------
+// nextInt(bound) : uniform integer within [0, bound[
+//
+// notes : unlike 'rand() % bound', there is no modulo bias
+// -------------------------------------------------------------------------
+
+int Random::nextInt(int i_bound)
+{
+  if (i_bound <= 1) return 0;
+
+  quint32 bound     = (quint32)i_bound;
+  quint32 threshold = (quint32)(-bound) % bound;
+  for (;;) {
+    quint32 r = next();
+    if (r >= threshold) return (int)(r % bound);
+  }
+}
+
+double Random::nextDouble()
+{
+  return next() * (1. / 4294967296.);
+}
+
+// -------------------------------------------------------------------------
+// state(), setState() : generator state, to save and restore it
+// -------------------------------------------------------------------------
+
+void Random::state(quint64 o_state[3]) const
+{
+  o_state[0] = m_state;
+  o_state[1] = m_inc;
+  o_state[2] = m_splits;
+}
+
+void Random::setState(const quint64 i_state[3])
+{
+  m_state  = i_state[0];
+  m_inc    = i_state[1] | 1;
+  m_splits = i_state[2];
+}
+
+// -------------------------------------------------------------------------
+// split() : derive a new independent generator
+//
+// notes : the new stream is derived from this stream and the number of
+//         generators already derived, so the result is deterministic
+// -------------------------------------------------------------------------
+
+Random Random::split()
+{
+  quint64 stream = (m_inc >> 1) ^ ((++m_splits) * PCG_MULTIPLIER);
+  // two statements : the order of the draws must not be left to the
+  // compiler
+  quint64 high   = next();
+  quint64 low    = next();
+  return Random((high << 32) | low, stream);
+}
@@ -0,0 +1,63 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+class   Random;
+
+#include <QtGlobal>
+
+class Random
+//
+// Random : small PCG32 pseudo-random number generator
+//
+//   - every generator owns its state (no shared libc rand() state)
+//   - a generator is defined by a seed and a stream, two generators
+//     using different streams produce independent sequences
+//   - split() derives a new generator on a new stream, so that a task
+//     can get its own generator and stay deterministic
+//
+{
+ public:
+  Random(quint64 i_seed = 42, quint64 i_stream = 0);
+
+  // restart the sequence
+  void seed(quint64 i_seed, quint64 i_stream = 0);
+
+  // next random values
+  quint32 next();               // uniform within [0, 2^32[
+  int     nextInt(int i_bound); // uniform within [0, bound[
+  double  nextDouble();         // uniform within [0, 1[
+
+  // derive a new independent generator
+  Random split();
+
+  // generator state, to save and restore it
+  void state(quint64 o_state[3]) const;
+  void setState(const quint64 i_state[3]);
+
+ private:
+  quint64 m_state;   // current state of the generator
+  quint64 m_inc;     // stream increment (always odd)
+  quint64 m_splits;  // how many generators were derived from this one
+};
+
+#endif // RANDOM_H
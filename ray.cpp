@@ -0,0 +1,74 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ray.h"
+#include "boundingsphere.h"
+#include <cmath>
+
+Ray::Ray(const Vector& i_origin, const Vector& i_direction)
+  :m_origin(i_origin),
+   m_direction(i_direction)
+{
+  m_direction.l2normalize();
+}
+
+const Vector& Ray::origin() const
+{
+  return m_origin;
+}
+
+const Vector& Ray::direction() const
+{
+  return m_direction;
+}
+
+Vector Ray::at(double i_distance) const
+{
+  return m_origin + m_direction * i_distance;
+}
+
+// -------------------------------------------------------------------------
+// intersects(bounding sphere, near, far) : does the ray go through 's'?
+//
+// near, far    : if non-null, set to the distances where the ray gets in
+//                and out of the sphere (near < 0 -> the ray starts inside)
+// return value : 'false' if the ray misses the sphere, or if the sphere
+//                is behind the origin
+// -------------------------------------------------------------------------
+
+bool Ray::intersects(const BoundingSphere& s,
+                     double* o_near, double* o_far) const
+{
+  if (s.isNull()) return false;
+
+  Vector oc = m_origin - s.center();
+  double b  = oc.dotProduct(m_direction);
+  double c  = oc.dotProduct(oc) - s.radius() * s.radius();
+  double disc = b * b - c;
+  if (disc < 0.) return false;
+
+  double root = sqrt(disc);
+  if (-b + root < 0.) return false;
+
+  if (o_near) *o_near = -b - root;
+  if (o_far)  *o_far  = -b + root;
+  return true;
+}
@@ -0,0 +1,53 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RAY_H
+#define RAY_H
+class   Ray;
+
+class BoundingSphere;
+#include "vector.h"
+
+class Ray
+//
+// Ray : half line from an origin point, in a direction (unit vector)
+//
+{
+ public:
+  Ray(const Vector& i_origin = Vector(),
+      const Vector& i_direction = Vector(0., 0., -1.));
+
+  const Vector& origin() const;
+  const Vector& direction() const;
+
+  // point at 'distance' along the ray
+  Vector at(double i_distance) const;
+
+  // distances along the ray to the sphere surface (false -> missed)
+  bool intersects(const BoundingSphere& s,
+                  double* o_near = 0, double* o_far = 0) const;
+
+ private:
+  Vector m_origin;     // where the ray starts
+  Vector m_direction;  // where it goes (unit vector)
+};
+
+#endif // RAY_H
@@ -0,0 +1,267 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "renderbench.h"
+#include "scene.h"
+#include "sceneloader.h"
+#include "camera.h"
+#include "texture.h"
+#include "materialregistry.h"
+#include "lightingshader.h"
+#include <QtOpenGL>
+#include <QGLFramebufferObject>
+#include <QElapsedTimer>
+#include <QDir>
+#include <algorithm>
+#include <cstdio>
+
+#define DEFAULT_WIDTH   640
+#define DEFAULT_HEIGHT  480
+#define DEFAULT_TICK    16    // simulation tick (ms)
+
+#define CAMERA_DISTANCE 15.   // distance from the origin (m)
+#define CAMERA_RANGE    100.  // distance from the origin to the horizon
+#define CAMERA_TILT     20.   // looking down a bit (degrees)
+#define CAMERA_HEIGHT   1.    // the camera looks a bit over the grass (m)
+
+// -------------------------------------------------------------------------
+// OffscreenWidget : hidden QGLWidget, only there for its opengl context
+//                   (textures are bound through a QGLWidget)
+// -------------------------------------------------------------------------
+
+class OffscreenWidget : public QGLWidget
+{
+ public:
+  OffscreenWidget() :QGLWidget() {}
+
+  // same opengl state as GLDemoWidget
+  void setup(int i_width, int i_height)
+  {
+    glViewport(0, 0, i_width, i_height);
+    glClearColor(0.0, 0.0, 0.8, 1.0);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glEnable(GL_NORMALIZE);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+  }
+};
+
+RenderBench::RenderBench()
+  :m_frames(0),
+   m_width(DEFAULT_WIDTH),
+   m_height(DEFAULT_HEIGHT),
+   m_tick_ms(DEFAULT_TICK),
+   m_scene(),
+   m_dump(),
+   m_output(),
+   m_valid(true)
+{
+}
+
+RenderBench::~RenderBench()
+{
+}
+
+// -------------------------------------------------------------------------
+// parseArguments(args) : read render benchmark options (see renderbench.h)
+//
+// return value : 'false' if no render benchmark was asked for
+// -------------------------------------------------------------------------
+
+bool RenderBench::parseArguments(const QStringList& i_args)
+{
+  bool bench = false;
+
+  for (int i = 1; i < i_args.size(); i++) {
+    const QString& arg = i_args.at(i);
+    QString value = (i + 1 < i_args.size()) ? i_args.at(i + 1) : QString();
+    bool ok = true;
+
+    if      (arg == "--render-bench") { bench = true;
+                                        m_frames = value.toInt(&ok); }
+    else if (arg == "--tick")           m_tick_ms = value.toInt(&ok);
+    else if (arg == "--scene")          m_scene  = value;
+    else if (arg == "--dump")           m_dump   = value;
+    else if (arg == "--output")         m_output = value;
+    else if (arg == "--size") {
+      QStringList size = value.split("x");
+      ok = (size.size() == 2);
+      if (ok) m_width = size.at(0).toInt(&ok);
+      if (ok) m_height = size.at(1).toInt(&ok);
+    }
+    else continue; // not a render benchmark option (may be a Qt option)
+
+    // the option value has been used
+    i++;
+    if (!ok) m_valid = false;
+  }
+  if (!bench) return false;
+  if ((m_frames <= 0) || (m_width <= 0) || (m_height <= 0) ||
+      (m_tick_ms <= 0))
+    m_valid = false;
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// run() : render all the frames and report frame times
+//
+// notes : a frame time is the time to draw the scene and wait for opengl
+//         to finish (glFinish), the simulation tick and the ppm dump are
+//         not part of it
+// -------------------------------------------------------------------------
+
+int RenderBench::run()
+{
+  if (!m_valid) {
+    fprintf(stderr, "usage : --render-bench N [--size WxH] [--tick MS] "
+            "[--scene FILE] [--dump DIR] [--output FILE]\n");
+    return 1;
+  }
+
+  // opengl context and offscreen frame buffer
+  OffscreenWidget gl;
+  gl.makeCurrent();
+  if (!gl.isValid() || !QGLFramebufferObject::hasOpenGLFramebufferObjects()) {
+    fprintf(stderr, "no opengl framebuffer object support\n");
+    return 1;
+  }
+  QGLFramebufferObject fbo(m_width, m_height, QGLFramebufferObject::Depth);
+  if (!fbo.isValid() || !fbo.bind()) {
+    fprintf(stderr, "can't create a %dx%d framebuffer object\n",
+            m_width, m_height);
+    return 1;
+  }
+  gl.setup(m_width, m_height);
+
+  if (!m_dump.isEmpty() && !QDir(m_dump).mkpath(".")) {
+    fprintf(stderr, "can't create %s\n", m_dump.toLocal8Bit().constData());
+    return 1;
+  }
+
+  // the scene
+  Scene scene;
+  if (!m_scene.isEmpty()) {
+    SceneLoader loader;
+    if (!loader.load(m_scene, scene)) {
+      fprintf(stderr, "%s : %s\n", m_scene.toLocal8Bit().constData(),
+              loader.errorString().toLocal8Bit().constData());
+      return 1;
+    }
+  }
+
+  // the camera orbits the origin once during the benchmark
+  Camera camera(CAMERA_DISTANCE, CAMERA_RANGE);
+  camera.setAspectRatio((double)m_width / (double)m_height);
+  camera.setTilt(CAMERA_TILT);
+  camera.setTarget(0., CAMERA_HEIGHT, 0.);
+
+  vec_times times(m_frames);
+  std::vector<unsigned char> rgb;
+  if (!m_dump.isEmpty()) rgb.resize(m_width * m_height * 3);
+  QElapsedTimer timer;
+
+  for (int i = 0; i < m_frames; i++) {
+    scene.tick(m_tick_ms);
+    camera.setRotate((360. * i) / m_frames);
+
+    timer.start();
+    camera.place();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glMatrixMode(GL_MODELVIEW);
+    Texture::forgetBindings();
+    MaterialRegistry::forgetApplied();
+    LightingShader::begin();
+    scene.draw(&gl);
+    LightingShader::end();
+    glFinish();
+    times[i] = (double)timer.nsecsElapsed() / 1.e6;
+
+    if (!rgb.empty()) {
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE,
+                   &rgb[0]);
+      if (!writePPM(i, rgb)) return 1;
+    }
+  }
+
+  fbo.release();
+  writeResults(times);
+  return 0;
+}
+
+// -------------------------------------------------------------------------
+// writePPM(frame, rgb) : write a frame as DIR/frame_NNNNN.ppm
+//
+// notes : opengl rows go upward, ppm rows go downward
+// -------------------------------------------------------------------------
+
+bool RenderBench::writePPM(int i_frame,
+                           const std::vector<unsigned char>& i_rgb) const
+{
+  char name[32];
+  sprintf(name, "frame_%05d.ppm", i_frame);
+  QString file = QDir(m_dump).filePath(name);
+
+  FILE* f = fopen(file.toLocal8Bit().constData(), "wb");
+  if (!f) {
+    fprintf(stderr, "can't write %s\n", file.toLocal8Bit().constData());
+    return false;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", m_width, m_height);
+  for (int y = m_height - 1; y >= 0; y--)
+    fwrite(&i_rgb[y * m_width * 3], 1, m_width * 3, f);
+  fclose(f);
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// writeResults(times) : frame time summary, and csv file if asked for
+// -------------------------------------------------------------------------
+
+void RenderBench::writeResults(const vec_times& i_times) const
+{
+  if (!m_output.isEmpty()) {
+    FILE* f = fopen(m_output.toLocal8Bit().constData(), "w");
+    if (f) {
+      fprintf(f, "frame,ms\n");
+      for (unsigned int i = 0; i < i_times.size(); i++)
+        fprintf(f, "%u,%.4f\n", i, i_times[i]);
+      fclose(f);
+    }
+    else
+      fprintf(stderr, "can't write %s\n", m_output.toLocal8Bit().constData());
+  }
+
+  vec_times sorted(i_times);
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0.;
+  for (unsigned int i = 0; i < sorted.size(); i++) total += sorted[i];
+  int n = (int)sorted.size();
+
+  printf("frames    %d (%dx%d)\n", n, m_width, m_height);
+  printf("mean      %.3f ms (%.1f fps)\n", total / n, (1000. * n) / total);
+  printf("min       %.3f ms\n", sorted[0]);
+  printf("median    %.3f ms\n", sorted[n / 2]);
+  printf("95%%       %.3f ms\n", sorted[(n * 95) / 100]);
+  printf("max       %.3f ms\n", sorted[n - 1]);
+}
@@ -0,0 +1,76 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RENDERBENCH_H
+#define RENDERBENCH_H
+class   RenderBench;
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class RenderBench
+//
+// RenderBench : render the scene offscreen for a given number of frames,
+//               from a fixed camera path, and report frame times
+//
+//   --render-bench N     frames to render
+//   --size WxH           frame size                         (640x480)
+//   --tick MS            simulation tick between frames     (16)
+//   --scene FILE         scene description file (see SceneLoader)
+//   --dump DIR           write each frame as DIR/frame_NNNNN.ppm
+//   --output FILE        frame times as csv            (no csv file)
+//
+//   the scene is drawn in a framebuffer object of a hidden QGLWidget, so
+//   no window is ever shown. on a host without display, run it with a
+//   virtual X server and a software opengl (ex: xvfb-run with mesa).
+//
+//   the simulation is deterministic and the camera orbits the origin,
+//   so dumped frames can be compared from one build to another.
+//
+{
+ public:
+  RenderBench();
+  ~RenderBench();
+
+  // read options, 'false' if no render benchmark was asked for
+  bool parseArguments(const QStringList& i_args);
+
+  // render all the frames (return value : process exit code)
+  int run();
+
+ private:
+  typedef std::vector<double> vec_times;
+
+  bool writePPM(int i_frame, const std::vector<unsigned char>& i_rgb) const;
+  void writeResults(const vec_times& i_times) const;
+
+  int     m_frames;   // frames to render
+  int     m_width;    // frame width  (pixels)
+  int     m_height;   // frame height (pixels)
+  int     m_tick_ms;  // simulation tick between frames
+  QString m_scene;    // scene description file (empty -> default)
+  QString m_dump;     // ppm directory (empty -> no dump)
+  QString m_output;   // csv file (empty -> no csv)
+  bool    m_valid;    // were the arguments understood?
+};
+
+#endif // RENDERBENCH_H
@@ -29,59 +29,211 @@
 #include "texture.h"
 #include "color.h"
 #include "sphere.h"
-#include <cstdlib>
+#include "snapshot.h"
+#include "scheduler.h"
+#include "lightingshader.h"
+#include <QString>
 #include <cmath>
+#include <algorithm>
 #include <QtOpenGL>
 
+// default scene tunables (see SceneParameters)
 #define WORLD_RADIUS   1.e10  // radius of the sphere the world is in
 #define MAXIMUM_SHEEP  7      // how many sheep will we have to protect?
 #define LIMIT_GRASS    500.   // where does the field of grass end?
 #define BIG_BALL_ACCEL 0.08   // Big Red Ball acceleration (m/s^2)
+#define SCENE_SEED     42     // scene random generator seed
+#define SPAWN_POINT    Vector(0., 25., 0.) // where new sheep come from
+#define SPAWN_SIZE     (0.70 * 0.75)       // new sheep are 3/4 our hero
+#define RESTITUTION    0.3    // velocity kept by bounces
+#define FRICTION       0.3    // friction between bodies
+#define SOLVER_ITERATIONS 8   // contact solver iterations per step
+#define PAGING_CELL    0.     // world paging cells (m), 0 -> no paging
 
-Scene::Scene()
+// floating origin (see rebase), the origin moves by whole grass tiles
+#define REBASE_DISTANCE 100.  // distance between two origins (m)
+
+// smallest changes worth a redraw (see Scene::moved)
+#define REDRAW_DISTANCE    1.e-4  // position (m), rotation matrix terms
+#define REDRAW_PHASE       1.e-3  // sheep animation phase (cycles)
+#define REDRAW_DEGREES     1.e-2  // sheep orientation (degrees)
+
+// blob shadows (see drawShadows)
+#define SHADOW_SIZE    1.2    // shadow radius / bounding sphere radius
+#define SHADOW_ALPHA   0.6    // shadow opacity on the ground
+#define SHADOW_FADE    4.     // gone at x bounding sphere radius high
+
+// fewer children are not worth a job (see setScheduler)
+#define CHILDREN_PER_JOB 64
+
+// sheep animation level of detail (see cull), distances to the camera
+#define HALF_RATE_DISTANCE     40.  // farther, legs move every 2 steps (m)
+#define QUARTER_RATE_DISTANCE  100. // farther, legs move every 4 steps (m)
+
+// -------------------------------------------------------------------------
+// Ticks : animation tick of a range of children
+// -------------------------------------------------------------------------
+
+class Ticks : public Loop
+{
+ public:
+  Ticks(const Globject::vec_globject& i_objects, double i_sec)
+    :Loop(), m_objects(i_objects), m_sec(i_sec) {}
+
+  virtual void run(int i_begin, int i_end)
+  {
+    for (int i = i_begin; i < i_end; i++)
+      m_objects[i]->tick(m_sec);
+  }
+
+ private:
+  const Globject::vec_globject& m_objects;
+  double                        m_sec;
+};
+
+// -------------------------------------------------------------------------
+// Culling : which children of a range are in the view volume, and how
+//           often the sheep among them should be animated
+// -------------------------------------------------------------------------
+
+class Culling : public Loop
+{
+ public:
+  Culling(const Globject::vec_globject& i_objects,
+          const double i_planes[6][4], const Vector& i_eye,
+          std::vector<char>& o_inside)
+    :Loop(), m_objects(i_objects), mp_planes(i_planes), m_eye(i_eye),
+     m_inside(o_inside) {}
+
+  virtual void run(int i_begin, int i_end);
+
+ private:
+  const Globject::vec_globject& m_objects;
+  const double                  (*mp_planes)[4];
+  Vector                        m_eye;
+  std::vector<char>&            m_inside;
+};
+
+void Culling::run(int i_begin, int i_end)
+{
+  for (int i = i_begin; i < i_end; i++) {
+    BoundingSphere bs = m_objects[i]->boundingSphere();
+    const Vector& c = bs.center();
+    char inside = 1;
+    for (int p = 0; (p < 6) && inside; p++) {
+      const double* plane = mp_planes[p];
+      if (plane[0] * c.x() + plane[1] * c.y() + plane[2] * c.z() +
+          plane[3] < -bs.radius())
+        inside = 0;
+    }
+    m_inside[i] = inside;
+
+    // hidden sheep are frozen, far away ones move their legs less often
+    Sheep* sheep = dynamic_cast<Sheep*>(m_objects[i]);
+    if (sheep) {
+      double distance = (c - m_eye).l2norm() - bs.radius();
+      int rate = 1;
+      if (!inside)                          rate = 0; else
+      if (distance > QUARTER_RATE_DISTANCE) rate = 4; else
+      if (distance > HALF_RATE_DISTANCE)    rate = 2;
+      sheep->setAnimationRate(rate);
+    }
+  }
+}
+
+SceneParameters::SceneParameters()
+  :seed(SCENE_SEED),
+   maximumSheep(MAXIMUM_SHEEP),
+   limitGrass(LIMIT_GRASS),
+   bigBallAccel(BIG_BALL_ACCEL),
+   worldRadius(WORLD_RADIUS),
+   spawnPoint(SPAWN_POINT),
+   restitution(RESTITUTION),
+   friction(FRICTION),
+   solverIterations(SOLVER_ITERATIONS),
+   cellSize(PAGING_CELL)
+{
+}
+
+SceneStats::SceneStats()
+  :seconds(0.),
+   sheep(0),
+   collisions(0),
+   victimsHit(0),
+   timeSurvived(0.)
+{
+}
+
+Scene::Scene(const SceneParameters& i_params)
   :Globject(),
+   mp_scheduler(0),
+   m_params(i_params),
+   m_stats(),
    m_targets(),
    m_nextTargetId(0),
    m_textures(),
+   m_atlas(),
+   m_terrain(),
+   m_shadows(),
+   m_stream(),
    m_sheep_counter(0),
    m_victims(),
-   m_current_victim(-1),
+   m_grid(),
+   m_herd(),
+   m_hierarchy(),
+   m_pursuers(),
+   m_flock(),
    mp_big_ball(0),
-   m_evil_big_ball(true)
+   mp_checkered(0),
+   mp_blob(0),
+   m_evil_big_ball(true),
+   m_random(i_params.seed),
+   m_touched(),
+   m_contacts(),
+   m_solver(),
+   m_animator(),
+   m_drawn(),
+   m_previous(),
+   m_current(),
+   m_inside(),
+   m_culled(),
+   m_origin(),
+   m_focus(),
+   m_pager()
 {
   // the scene is in a sphere so large that the floor is almost flat
-  BoundingSphere limits(WORLD_RADIUS, Vector(0., WORLD_RADIUS, 0.));
-  setContainerLimits(limits);
+  setParameters(i_params);
+
+  // the Big Red Ball incredible red checkered texture !
+  mp_checkered = Texture::newCheckeredTexture(128, Color::red);
+  m_textures.push_back(mp_checkered);
+
+  // sheep cast shadows (see drawShadows)
+  mp_blob = Texture::newBlobTexture(64);
+  m_textures.push_back(mp_blob);
 
-  // what is in the scene?
+  // what is in the scene? (see SceneLoader for other scenes)
   {
     // first, there is our hero : the Shaolin Sheep !
-    Sheep* bah = new Sheep(0.70);
+    Sheep* bah = addSheep(0.70, false);
     bah->transform().setTranslation(Vector(0., 0., 10.));
     bah->transform().setRotation( 30., Vector::i);
     bah->transform().addRotation( 40., Vector::k);
     bah->transform().addRotation(-35., Vector::j);
-    bah->setMovable(true);
-    addChild(bah);
     addTarget(bah);
 
     // and, its worst enemy : the Big Red Checkered Ball !
-    Ball* red = new Ball(2.);
+    Ball* red = addBall(2., true);
     red->transform().setTranslation(Vector(0., 1., -10.));
-    red->setMovable(true);
-    addChild(red);
     addTarget(red);
-
-    // with its incredible red checkered texture !
-    Texture* tex = Texture::newCheckeredTexture(128, Color::red);
-    red->setTexture(tex);
-    m_textures.push_back(tex);
-    mp_big_ball = red;
   }
 }
 
 Scene::~Scene()
 {
+  // the sheep are deleted after the animator (see ~Globject)
+  m_animator.clear();
+
   // free all the textures
   for (vec_textures::iterator it = m_textures.begin();
        it != m_textures.end(); it++) {
@@ -90,52 +242,490 @@ Scene::~Scene()
   m_textures.clear();
 }
 
+// -------------------------------------------------------------------------
+// setScheduler(scheduler) : run the steps on the threads of a scheduler
+//
+// notes : the children are animated and moved, and their bounding
+//         spheres read, by all the threads. everything else (collisions,
+//         herd, pursuit) is still done in order on the calling thread.
+//         without a scheduler (the default), steps are reproducible.
+// -------------------------------------------------------------------------
+
+void Scene::setScheduler(Scheduler* i_scheduler)
+{
+  mp_scheduler = i_scheduler;
+  m_animator.setScheduler(i_scheduler);
+}
+
+// -------------------------------------------------------------------------
+// tick(ms), step(seconds) : move the scene forward
+//
+// return value : 'true' if the scene needs to be redrawn
+// -------------------------------------------------------------------------
+
 bool Scene::tick(int i_ms)
+{
+  return step((double)i_ms / 1000.);
+}
+
+bool Scene::step(double i_sec)
 {
   // we need some sheep to protect from the Big Red Checkered Ball
-  if ((m_sheep_counter < MAXIMUM_SHEEP) && (rand() % 100 == 0)) {
+  if ((m_sheep_counter < m_params.maximumSheep) &&
+      (m_random.nextInt(100) == 0)) {
     // new sheep have 3/4 the size of our hero
-    Sheep* sheep = new Sheep(0.70 * 0.75);
-    sheep->setMovable(true);
-    m_victims.push_back(sheep);
-    m_sheep_counter++;
+    Sheep* sheep = addSheep(SPAWN_SIZE, true);
 
     // they come from the skies !
-    sheep->transform().setTranslation(Vector(0., 25., 0.));
-    sheep->setVelocity
-      (Vector((rand()%10)/10.-0.5, (rand()%10)/10., (rand()%10)/10.-0.5));
-    addChild(sheep);
-  }
-
-  // the evil Big Red Checkered Ball wants to roll over the sheep!
-  if (((m_current_victim < 0) || (rand() % 1000 == 0)) && m_sheep_counter)
-    m_current_victim = (rand() % m_sheep_counter);
-  if (m_evil_big_ball && mp_big_ball && (m_current_victim >= 0)) {
-    Vector dir = (m_victims[m_current_victim])->position() -
-      mp_big_ball->position();
-    dir.setY(0.); dir.l2normalize();
-    mp_big_ball->setVelocity
-      (mp_big_ball->velocity() + dir * BIG_BALL_ACCEL);
+    sheep->transform().setTranslation(m_params.spawnPoint - m_origin);
+    double vx = m_random.nextInt(10) / 10. - 0.5;
+    double vy = m_random.nextInt(10) / 10.;
+    double vz = m_random.nextInt(10) / 10. - 0.5;
+    sheep->setVelocity(Vector(vx, vy, vz));
   }
 
+  // the evil Big Red Checkered Balls want to roll over the sheep!
+  pursue();
+
+  // ... but the sheep stick together, and run away from them
+  m_flock.steer(i_sec, m_victims, m_pursuers);
+
   // if a child fled away in the sky, teleport it back to the center
-  for (vec_globject::const_iterator it = children().begin();
-       it != children().end(); it++) {
-    if ((fabs((*it)->position().x()) > LIMIT_GRASS) ||
-        (fabs((*it)->position().z()) > LIMIT_GRASS)) {
-      (*it)->setPosition(Vector(0., 5., 0.));
+  // (in a paged world, it is stored with the cell it went to instead)
+  if (m_pager.enabled()) {
+    rebase();
+    page();
+  }
+  else {
+    for (vec_globject::const_iterator it = children().begin();
+         it != children().end(); it++) {
+      if ((fabs((*it)->position().x()) > m_params.limitGrass) ||
+          (fabs((*it)->position().z()) > m_params.limitGrass)) {
+        (*it)->setPosition(Vector(0., 5., 0.));
+      }
     }
   }
 
+  // keep where everything was, to draw in between (see beginInterpolation)
+  {
+    const vec_globject& objs = children();
+    m_previous.resize(objs.size());
+    for (unsigned int i = 0; i < objs.size(); i++)
+      m_previous[i] = objs[i]->position();
+  }
+
   // move and animate each part of the scene
-  double seconds = (double)i_ms / 1000.;
-  bool res = Globject::tick(seconds);
+  {
+    Ticks ticks(children(), i_sec);
+    if (mp_scheduler)
+      mp_scheduler->parallelFor(children().size(), ticks, CHILDREN_PER_JOB);
+    else
+      ticks.run(0, children().size());
+    globject_tick(i_sec);
+  }
+
+  // check for collisions, etc. (the sheep are posed before each check)
+  m_contacts.clear();
+  Physics::tick(i_sec, *this, &m_contacts, &m_animator, mp_scheduler,
+                &m_solver);
+  m_animator.update();
+  m_grid.update(mp_scheduler);
+  m_herd.update(mp_scheduler);
+  m_hierarchy.update(children(), mp_scheduler);
+
+  updateStats(i_sec);
+
+  // objects at rest are still nudged by gravity and ground contacts,
+  // only visible changes are worth a redraw
+  return moved();
+}
+
+// -------------------------------------------------------------------------
+// page() : store the children gone to the cells that are not loaded, bring
+//          back the ones read from the cells loaded again
+//
+// notes : the targets are never stored, the camera may follow them
+//         anywhere. stored bodies are frozen until their cell is loaded,
+//         and they come back a few steps after (see WorldPager)
+// -------------------------------------------------------------------------
+
+void Scene::page()
+{
+  m_pager.setFocus(m_origin + m_focus);
+
+  // the grass and the grids follow the focus, cell by cell
+  Vector center = m_pager.center(m_pager.cell(m_origin + m_focus)) -
+                  m_origin;
+  m_terrain.setCenter(center.x(), center.z());
+  m_grid.setCenter(center.x(), center.z());
+  m_herd.setCenter(center.x(), center.z());
+
+  // children out of the loaded cells
+  WorldPager::vec_bodies stored;
+  vec_globject leaving;
+  const vec_globject& objs = children();
+  for (unsigned int i = 0; i < objs.size(); i++) {
+    WorldPager::Cell cell = m_pager.cell(m_origin + objs[i]->position());
+    if (m_pager.loaded(cell) || isTarget(objs[i])) continue;
+
+    stored.push_back(WorldPager::Body());
+    storeBody(objs[i], stored.back());
+    leaving.push_back(objs[i]);
+  }
+  for (unsigned int i = 0; i < leaving.size(); i++) {
+    removeBody(leaving[i]);
+    delete leaving[i];
+  }
+  m_pager.store(stored);
+
+  // children of the cells loaded again
+  WorldPager::vec_bodies loaded;
+  if (m_pager.take(loaded) == 0) return;
+  for (unsigned int i = 0; i < loaded.size(); i++)
+    restoreBody(loaded[i]);
+  updateAtlas();
+}
+
+// -------------------------------------------------------------------------
+// rebase()          : move the origin of the scene near the focus
+// setOrigin(origin) : move it anywhere in the world
+//
+// notes : wherever the world is looked at from, the positions within the
+//         scene stay small : the floats sent to opengl, and the sums of
+//         the steps, keep their precision (floating origin). what leaves
+//         the scene, stored or saved, is in world coordinates.
+// -------------------------------------------------------------------------
+
+void Scene::rebase()
+{
+  Vector shift(floor(m_focus.x() / REBASE_DISTANCE + 0.5) * REBASE_DISTANCE,
+               0.,
+               floor(m_focus.z() / REBASE_DISTANCE + 0.5) * REBASE_DISTANCE);
+  if (!shift.isNull()) setOrigin(m_origin + shift);
+}
+
+void Scene::setOrigin(const Vector& i_origin)
+{
+  Vector shift = i_origin - m_origin;
+  m_origin = i_origin;
+  m_focus -= shift;
+
+  const vec_globject& objs = children();
+  for (unsigned int i = 0; i < objs.size(); i++)
+    objs[i]->setPosition(objs[i]->position() - shift);
+
+  // the floor stays where it is in the world
+  BoundingSphere limits(m_params.worldRadius,
+                        Vector(0., m_params.worldRadius, 0.) - m_origin);
+  setContainerLimits(limits);
+}
 
-  // check for collisions, etc.
-  if (Physics::tick(seconds, *this)) res = true;
+const Vector& Scene::origin() const
+{
+  return m_origin;
+}
+
+// -------------------------------------------------------------------------
+// storeBody(globject, body), restoreBody(body) : what is kept of a child
+//                                                while it is paged out
+// removeBody(globject) : take a child out of the scene (not deleted)
+// -------------------------------------------------------------------------
+
+void Scene::storeBody(const Globject* i_object, WorldPager::Body& o_body)
+  const
+{
+  Globject* o     = (Globject*)i_object;
+  Sheep*    sheep = dynamic_cast<Sheep*>(o);
+  Ball*     ball  = dynamic_cast<Ball*>(o);
+
+  // (floats, from the corner of the cell)
+  Vector world = m_origin + o->position();
+  Vector from  = world - m_pager.corner(m_pager.cell(world));
+  o_body.cell  = m_pager.cell(world);
+
+  o_body.kind    = sheep ? Snapshot::SHEEP : Snapshot::BALL;
+  o_body.flags   = (o->movable() ? Snapshot::MOVABLE : 0);
+  o_body.size    = 0.;
+  o_body.phase   = 0.;
+  o_body.orientation = 0.;
+  o_body.texture = -1;
+  if (sheep) {
+    if (sheep->walking()) o_body.flags |= Snapshot::WALKING;
+    if (sheep->waiting()) o_body.flags |= Snapshot::WAITING;
+    o_body.size        = sheep->size();
+    o_body.phase       = sheep->phase();
+    o_body.orientation = sheep->orientation();
+  }
+  if (ball) {
+    o_body.size = ball->radius();
+    vec_textures::const_iterator t =
+      std::find(m_textures.begin(), m_textures.end(), ball->texture());
+    if (t != m_textures.end()) o_body.texture = t - m_textures.begin();
+  }
+  if (std::find(m_pursuers.begin(), m_pursuers.end(), o) !=
+      m_pursuers.end())
+    o_body.flags |= Snapshot::BIG_BALL;
+  o_body.victim = (std::find(m_victims.begin(), m_victims.end(), o) !=
+                   m_victims.end());
+
+  const Transform& tr = o->transform();
+  for (int k = 0; k < 3; k++) {
+    o_body.position[k] = (float)from[k];
+    o_body.velocity[k] = (float)o->velocity()[k];
+    o_body.scaling[k]  = (float)tr.scaling()[k];
+  }
+  for (int c = 0; c < 3; c++)
+    for (int r = 0; r < 3; r++)
+      o_body.rotation[c*3 + r] = (float)tr.rotation().m(r, c);
+}
+
+void Scene::restoreBody(const WorldPager::Body& i_body)
+{
+  Globject* o = 0;
+  Sheep* sheep = 0;
+  Ball*  ball  = 0;
+  if (i_body.kind == Snapshot::SHEEP) o = sheep = new Sheep(i_body.size);
+  else                                o = ball  = new Ball(i_body.size);
+
+  const float* p = i_body.position;
+  const float* v = i_body.velocity;
+  const float* s = i_body.scaling;
+  const float* r = i_body.rotation;
+  Vector from = m_pager.corner(i_body.cell) - m_origin;
+  o->setMovable((i_body.flags & Snapshot::MOVABLE) != 0);
+  o->transform().setTranslation(from + Vector(p[0], p[1], p[2]));
+  o->transform().setScaling(Vector(s[0], s[1], s[2]));
+  Matrix rot;
+  rot.set(r[0], r[3], r[6], 0.,
+          r[1], r[4], r[7], 0.,
+          r[2], r[5], r[8], 0.,
+          0.,   0.,   0.,   1.);
+  o->transform().setRotation(rot);
+  o->setVelocity(Vector(v[0], v[1], v[2]));
+
+  if (sheep) {
+    sheep->setAnimator(&m_animator);
+    sheep->setAnimationState(i_body.phase, i_body.orientation,
+                             (i_body.flags & Snapshot::WALKING) != 0,
+                             (i_body.flags & Snapshot::WAITING) != 0);
+  }
+  if (ball && (i_body.texture >= 0) &&
+      (i_body.texture < (qint32)m_textures.size()))
+    ball->setTexture(m_textures[i_body.texture]);
+
+  addChild(o);
+  m_grid.insert(o);
+  if (i_body.victim) {
+    m_victims.push_back(o);
+    m_herd.insert(o);
+  }
+  if (i_body.flags & Snapshot::BIG_BALL) {
+    m_pursuers.push_back(o);
+    if (!mp_big_ball) mp_big_ball = o;
+  }
+}
+
+void Scene::removeBody(Globject* i_object)
+{
+  removeChild(i_object);
+  m_grid.remove(i_object);
+  m_herd.remove(i_object);
+  m_victims.erase(std::remove(m_victims.begin(), m_victims.end(),
+                              i_object), m_victims.end());
+  m_pursuers.erase(std::remove(m_pursuers.begin(), m_pursuers.end(),
+                               i_object), m_pursuers.end());
+  m_touched.erase(std::remove(m_touched.begin(), m_touched.end(),
+                              i_object), m_touched.end());
+  m_solver.forget(i_object);
+  if (mp_big_ball == i_object)
+    mp_big_ball = (m_pursuers.empty() ? 0 : m_pursuers[0]);
+}
+
+bool Scene::isTarget(const Globject* i_object) const
+{
+  for (map_globject::const_iterator it = m_targets.begin();
+       it != m_targets.end(); it++)
+    if ((*it).second == i_object) return true;
+  return false;
+}
+
+// -------------------------------------------------------------------------
+// beginInterpolation(alpha), endInterpolation() : draw between two steps
+//
+// notes : the scene is stepped at a fixed rate, and drawn at any rate in
+//         between. only positions are interpolated, rotations and sheep
+//         poses are those of the last step.
+// -------------------------------------------------------------------------
+
+void Scene::beginInterpolation(double i_alpha)
+{
+  const vec_globject& objs = children();
+  m_current.resize(objs.size());
+  for (unsigned int i = 0; i < objs.size(); i++) {
+    m_current[i] = objs[i]->position();
+    if (i < m_previous.size())
+      objs[i]->setPosition(m_previous[i] +
+                           (m_current[i] - m_previous[i]) * i_alpha);
+  }
+}
+
+void Scene::endInterpolation()
+{
+  const vec_globject& objs = children();
+  for (unsigned int i = 0; i < objs.size() && i < m_current.size(); i++)
+    objs[i]->setPosition(m_current[i]);
+  m_current.clear();
+
+  for (vec_globject::iterator it = m_culled.begin();
+       it != m_culled.end(); it++)
+    (*it)->setVisible(true);
+  m_culled.clear();
+}
+
+// -------------------------------------------------------------------------
+// setFocus(focus) : where the world is looked at from
+//
+// notes : only matters to a paged world, the cells around the focus are
+//         loaded by the next step (the focus is relative to the origin)
+// -------------------------------------------------------------------------
+
+void Scene::setFocus(const Vector& i_focus)
+{
+  m_focus = i_focus;
+}
+
+// -------------------------------------------------------------------------
+// cull() : hide the children out of the view volume, and choose the
+//          animation level of detail of the sheep
+//
+// notes : the six planes of the view volume are taken from the opengl
+//         projection and modelview matrices. the bounding spheres are
+//         tested by all the scheduler threads, if any. the sheep keep
+//         their animation rate until the next cull (see
+//         Sheep::setAnimationRate) : a scene never drawn this way is
+//         animated at full rate.
+// -------------------------------------------------------------------------
+
+void Scene::cull()
+{
+  GLdouble p[16], m[16];
+  glGetDoublev(GL_PROJECTION_MATRIX, p);
+  glGetDoublev(GL_MODELVIEW_MATRIX,  m);
+
+  // rows of projection * modelview (column major)
+  double row[4][4];
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++) {
+      row[r][c] = 0.;
+      for (int k = 0; k < 4; k++) row[r][c] += p[k * 4 + r] * m[c * 4 + k];
+    }
+
+  // left, right, bottom, top, near, far : inside when a.x + d >= 0
+  double planes[6][4];
+  for (int i = 0; i < 6; i++) {
+    double sign = (i % 2) ? -1. : 1.;
+    double norm = 0.;
+    for (int c = 0; c < 4; c++) {
+      planes[i][c] = row[3][c] + sign * row[i / 2][c];
+      if (c < 3) norm += planes[i][c] * planes[i][c];
+    }
+    norm = sqrt(norm);
+    if (norm > 0.)
+      for (int c = 0; c < 4; c++) planes[i][c] /= norm;
+  }
+
+  // the camera, where the modelview matrix takes the origin from
+  Vector eye(-(m[0] * m[12] + m[1] * m[13] + m[2]  * m[14]),
+             -(m[4] * m[12] + m[5] * m[13] + m[6]  * m[14]),
+             -(m[8] * m[12] + m[9] * m[13] + m[10] * m[14]));
+
+  const vec_globject& objs = children();
+  m_inside.resize(objs.size());
+  Culling culling(objs, planes, eye, m_inside);
+  if (mp_scheduler)
+    mp_scheduler->parallelFor(objs.size(), culling, CHILDREN_PER_JOB);
+  else
+    culling.run(0, objs.size());
+
+  for (unsigned int i = 0; i < objs.size(); i++)
+    if (!m_inside[i] && objs[i]->visible()) {
+      objs[i]->setVisible(false);
+      m_culled.push_back(objs[i]);
+    }
+}
+
+// -------------------------------------------------------------------------
+// moved() : did anything move visibly since the scene was last drawn?
+//
+// notes : changes are accumulated since the last draw, so slow motions
+//         still get drawn once they add up to something visible
+// -------------------------------------------------------------------------
+
+bool Scene::moved() const
+{
+  const vec_globject& objs = children();
+  if (objs.size() != m_drawn.size()) return true;
+
+  for (unsigned int i = 0; i < objs.size(); i++) {
+    const DrawnPose& a = m_drawn[i];
+    DrawnPose b = pose(objs[i]);
+    if ((a.object != b.object) || (a.waiting != b.waiting) ||
+        (fabs(a.phase       - b.phase)       > REDRAW_PHASE) ||
+        (fabs(a.orientation - b.orientation) > REDRAW_DEGREES) ||
+        ((a.position - b.position).l2norm()  > REDRAW_DISTANCE))
+      return true;
+
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        if (fabs(a.rotation.m(r, c) - b.rotation.m(r, c)) > REDRAW_DISTANCE)
+          return true;
+  }
+  return false;
+}
+
+Scene::DrawnPose Scene::pose(const Globject* i_object)
+{
+  DrawnPose res;
+  res.object      = i_object;
+  res.position    = i_object->position();
+  res.phase       = 0.;
+  res.orientation = 0.;
+  res.waiting     = false;
+
+  // (every child of the scene has a transform, it holds its position)
+  res.rotation = ((Globject*)i_object)->transform().rotation();
+
+  const Sheep* sheep = dynamic_cast<const Sheep*>(i_object);
+  if (sheep) {
+    res.phase       = sheep->phase();
+    res.orientation = sheep->orientation();
+    res.waiting     = sheep->waiting();
+  }
   return res;
 }
 
+// -------------------------------------------------------------------------
+// pursue() : each pursuing ball accelerates toward the nearest victim
+//
+// notes : the Big Red Ball leaves the sheep alone while it is not evil
+//         (someone else is in control)
+// -------------------------------------------------------------------------
+
+void Scene::pursue()
+{
+  vec_globject found;
+  for (vec_victims::const_iterator it = m_pursuers.begin();
+       it != m_pursuers.end(); it++) {
+    Globject* ball = (*it);
+    if ((ball == mp_big_ball) && !m_evil_big_ball) continue;
+    if (!m_herd.nearest(ball->position(), 1, found)) break;
+
+    Vector dir = found[0]->position() - ball->position();
+    dir.setY(0.); dir.l2normalize();
+    ball->setVelocity(ball->velocity() + dir * m_params.bigBallAccel);
+  }
+}
+
 // ------------------------------------------------------------------------
 // setEvilBigBall(evil) : is the big ball evil? (wants to attack the sheep)
 // ------------------------------------------------------------------------
@@ -150,6 +740,584 @@ const Globject* Scene::target(int i_id) const
   return (it == m_targets.end() ? 0 : (*it).second);
 }
 
+// -------------------------------------------------------------------------
+// nearest(point, count, found, victims), within(point, radius, found) :
+//   spatial queries on the children
+//
+// notes : see SpatialGrid. the children are sorted once per step, the
+//         ones added since are not found before the next step.
+// -------------------------------------------------------------------------
+
+int Scene::nearest(const Vector& i_point, int i_count,
+                   vec_globject& o_found, bool i_victims) const
+{
+  return (i_victims ? m_herd : m_grid).nearest(i_point, i_count, o_found);
+}
+
+int Scene::within(const Vector& i_point, double i_radius,
+                  vec_globject& o_found) const
+{
+  return m_grid.within(i_point, i_radius, o_found);
+}
+
+// -------------------------------------------------------------------------
+// pick(ray, distance) : first child whose bounding sphere is on the ray
+//
+// distance     : if non-null, set to the distance to the child
+// return value : the child, 0 -> none
+//
+// notes : the hierarchy is refitted once per step, so a pick only
+//         searches the few nodes along the ray
+// -------------------------------------------------------------------------
+
+Globject* Scene::pick(const Ray& i_ray, double* o_distance) const
+{
+  return m_hierarchy.rayCast(i_ray, o_distance);
+}
+
+// -------------------------------------------------------------------------
+// random() : scene pseudo-random number generator
+//
+// notes : each scene has its own generator, seeded at construction, so
+//         two scenes never interfere with each other
+// -------------------------------------------------------------------------
+
+Random& Scene::random()
+{
+  return m_random;
+}
+
+// -------------------------------------------------------------------------
+// parameters(), stats(), memoryStats() : scene tunables, herd survival
+//                                        metrics and memory footprint
+// -------------------------------------------------------------------------
+
+const SceneParameters& Scene::parameters() const
+{
+  return m_params;
+}
+
+// -------------------------------------------------------------------------
+// setParameters(params) : new scene tunables
+//
+// notes : the random sequence is restarted using the new seed
+// -------------------------------------------------------------------------
+
+void Scene::setParameters(const SceneParameters& i_params)
+{
+  m_params = i_params;
+  m_random.seed(m_params.seed);
+
+  BoundingSphere limits(m_params.worldRadius,
+                        Vector(0., m_params.worldRadius, 0.) - m_origin);
+  setContainerLimits(limits);
+  m_terrain.setLimit(m_params.limitGrass);
+  m_grid.setLimit(m_params.limitGrass);
+  m_herd.setLimit(m_params.limitGrass);
+
+  // the world is paged as far as the grass goes, around the focus
+  m_pager.setCellSize(m_params.cellSize);
+  m_pager.setRadius(m_params.limitGrass);
+  if (!m_pager.enabled()) {
+    m_terrain.setCenter(0., 0.);
+    m_grid.setCenter(0., 0.);
+    m_herd.setCenter(0., 0.);
+  }
+  m_solver.setRestitution(m_params.restitution);
+  m_solver.setFriction(m_params.friction);
+  m_solver.setIterations(m_params.solverIterations);
+}
+
+const SceneStats& Scene::stats() const
+{
+  return m_stats;
+}
+
+MemoryStats Scene::memoryStats() const
+{
+  return MemoryStats::current();
+}
+
+// -------------------------------------------------------------------------
+// clear() : remove everything from the scene (bodies, targets, stats)
+// -------------------------------------------------------------------------
+
+void Scene::clear()
+{
+  m_animator.clear();
+  deleteChildren();
+  m_targets.clear();
+  m_nextTargetId   = 0;
+  m_sheep_counter  = 0;
+  m_victims.clear();
+  m_grid.clear();
+  m_herd.clear();
+  m_hierarchy.clear();
+  m_pursuers.clear();
+  m_touched.clear();
+  m_contacts.clear();
+  m_solver.clear();
+  m_drawn.clear();
+  m_previous.clear();
+  m_current.clear();
+  m_pager.clear();
+  setOrigin(Vector());
+  mp_big_ball      = 0;
+  m_stats          = SceneStats();
+}
+
+// -------------------------------------------------------------------------
+// addSheep(size, victim) : add a new movable sheep to the scene
+//
+// victim : 'true' if the sheep is part of the herd to protect
+// -------------------------------------------------------------------------
+
+Sheep* Scene::addSheep(double i_size, bool i_victim)
+{
+  Sheep* sheep = new Sheep(i_size);
+  sheep->setMovable(true);
+  sheep->setAnimator(&m_animator);
+  updateAtlas();
+  if (i_victim) {
+    m_victims.push_back(sheep);
+    m_herd.insert(sheep);
+    m_sheep_counter++;
+  }
+  addChild(sheep);
+  m_grid.insert(sheep);
+  return sheep;
+}
+
+// -------------------------------------------------------------------------
+// addBall(radius, big_ball) : add a new movable ball to the scene
+//
+// big_ball : 'true' if the ball is a Big Red Checkered Ball, pursuing the
+//            sheep (the first one is the Big Red Ball, see setEvilBigBall)
+// -------------------------------------------------------------------------
+
+Ball* Scene::addBall(double i_radius, bool i_big_ball)
+{
+  Ball* ball = new Ball(i_radius);
+  ball->setMovable(true);
+  if (i_big_ball) {
+    ball->setTexture(mp_checkered);
+    m_pursuers.push_back(ball);
+    if (!mp_big_ball) mp_big_ball = ball;
+  }
+  addChild(ball);
+  m_grid.insert(ball);
+  updateAtlas();
+  return ball;
+}
+
+// -------------------------------------------------------------------------
+// updateAtlas() : pack the scene textures and the wool in one texture
+//
+// notes : the wool texture is only there once a sheep was created, and
+//         goes away with the last sheep
+// -------------------------------------------------------------------------
+
+void Scene::updateAtlas()
+{
+  bool changed = (Sheep::sp_wool && !m_atlas.contains(Sheep::sp_wool));
+  for (unsigned int i = 0; i < m_textures.size(); i++)
+    if (!m_atlas.contains(m_textures[i])) changed = true;
+  if (!changed) return;
+
+  m_atlas.clear();
+  m_atlas.add(Sheep::sp_wool);
+  for (unsigned int i = 0; i < m_textures.size(); i++)
+    m_atlas.add(m_textures[i]);
+  if (!m_atlas.build())
+    qWarning("scene : textures too large for an atlas");
+}
+
+// -------------------------------------------------------------------------
+// saveSnapshot(file) : save the whole scene state
+//
+// notes : bodies are saved as arrays (see Snapshot), textures are only
+//         referenced by the hash of their image. in a paged world, only
+//         the bodies of the loaded cells are saved. positions are saved
+//         in world coordinates, the scene is loaded around the origin.
+// -------------------------------------------------------------------------
+
+bool Scene::saveSnapshot(const QString& i_file) const
+{
+  const vec_globject& objs = children();
+
+  // textures used by the bodies
+  vec_textures textures;
+  for (unsigned int i = 0; i < objs.size(); i++) {
+    Texture* tex = 0;
+    if (dynamic_cast<Sheep*>(objs[i])) tex = Sheep::sp_wool;
+    if (dynamic_cast<Ball*>(objs[i]))  tex = ((Ball*)objs[i])->texture();
+    if (tex && (std::find(textures.begin(), textures.end(), tex) ==
+                textures.end()))
+      textures.push_back(tex);
+  }
+
+  // contact solver impulses, between bodies given by index
+  const ContactSolver::vec_impulses& impulses = m_solver.impulses();
+  std::map<const Globject*, int> index;
+  for (unsigned int i = 0; i < objs.size(); i++) index[objs[i]] = i;
+  index[0] = -1;
+
+  Snapshot snap;
+  snap.create(objs.size(), textures.size(), impulses.size());
+  {
+    SnapshotHeader& h = snap.header();
+    h.seed          = m_params.seed;
+    h.limitGrass    = m_params.limitGrass;
+    h.bigBallAccel  = m_params.bigBallAccel;
+    h.worldRadius   = m_params.worldRadius;
+    for (int k = 0; k < 3; k++) h.spawnPoint[k] = m_params.spawnPoint[k];
+    h.maximumSheep  = m_params.maximumSheep;
+    h.restitution   = m_params.restitution;
+    h.friction      = m_params.friction;
+    h.solverIterations = m_params.solverIterations;
+    h.seconds       = m_stats.seconds;
+    h.timeSurvived  = m_stats.timeSurvived;
+    h.collisions    = m_stats.collisions;
+    h.victimsHit    = m_stats.victimsHit;
+    h.sheepCounter  = m_sheep_counter; // (with the paged victims)
+    h.currentVictim = -1;
+    h.evilBigBall   = m_evil_big_ball;
+    m_random.state(h.random);
+
+    // (victims are chosen again at each step, this one is informative)
+    vec_globject found;
+    if (mp_big_ball && m_herd.nearest(mp_big_ball->position(), 1, found))
+      h.currentVictim = std::find(m_victims.begin(), m_victims.end(),
+                                  found[0]) - m_victims.begin();
+  }
+
+  quint64* hashes = (quint64*)snap.array(Snapshot::TEXTURE_HASH);
+  for (unsigned int t = 0; t < textures.size(); t++)
+    hashes[t] = textures[t]->hash();
+
+  // the solver sorts its impulses by address, they are saved by body
+  // index so that the same scene always gives the same file
+  typedef std::pair<std::pair<int, int>, unsigned int> sorted_impulse;
+  std::vector<sorted_impulse> sorted(impulses.size());
+  for (unsigned int c = 0; c < impulses.size(); c++)
+    sorted[c] = sorted_impulse(std::make_pair(index[impulses[c].a],
+                                              index[impulses[c].b]), c);
+  std::sort(sorted.begin(), sorted.end());
+
+  qint32* pair    = (qint32*)snap.array(Snapshot::CONTACT_PAIR);
+  double* impulse = (double*)snap.array(Snapshot::CONTACT_IMPULSE);
+  for (unsigned int c = 0; c < sorted.size(); c++) {
+    const ContactSolver::Impulse& imp = impulses[sorted[c].second];
+    pair[c*2]     = sorted[c].first.first;
+    pair[c*2 + 1] = sorted[c].first.second;
+    impulse[c*4]  = imp.normal;
+    for (int k = 0; k < 3; k++) impulse[c*4 + 1 + k] = imp.tangent[k];
+  }
+
+  qint32* kind     = (qint32*)snap.array(Snapshot::KIND);
+  qint32* flags    = (qint32*)snap.array(Snapshot::FLAGS);
+  qint32* target   = (qint32*)snap.array(Snapshot::TARGET);
+  qint32* victim   = (qint32*)snap.array(Snapshot::VICTIM);
+  qint32* texture  = (qint32*)snap.array(Snapshot::TEXTURE);
+  double* size     = (double*)snap.array(Snapshot::SIZE);
+  double* position = (double*)snap.array(Snapshot::POSITION);
+  double* velocity = (double*)snap.array(Snapshot::VELOCITY);
+  double* rotation = (double*)snap.array(Snapshot::ROTATION);
+  double* scaling  = (double*)snap.array(Snapshot::SCALING);
+  double* phase    = (double*)snap.array(Snapshot::PHASE);
+  double* orient   = (double*)snap.array(Snapshot::ORIENTATION);
+
+  for (unsigned int i = 0; i < objs.size(); i++) {
+    Globject* o     = objs[i];
+    Sheep*    sheep = dynamic_cast<Sheep*>(o);
+    Ball*     ball  = dynamic_cast<Ball*>(o);
+    if (!sheep && !ball) return false;
+
+    Texture* tex = sheep ? Sheep::sp_wool : ball->texture();
+    vec_textures::iterator t =
+      std::find(textures.begin(), textures.end(), tex);
+    texture[i] = (tex ? (t - textures.begin()) : -1);
+
+    kind[i]  = sheep ? Snapshot::SHEEP : Snapshot::BALL;
+    flags[i] = (o->movable() ? Snapshot::MOVABLE : 0);
+    if (sheep) {
+      if (sheep->walking()) flags[i] |= Snapshot::WALKING;
+      if (sheep->waiting()) flags[i] |= Snapshot::WAITING;
+      size[i]   = sheep->size();
+      phase[i]  = sheep->phase();
+      orient[i] = sheep->orientation();
+    }
+    else size[i] = ball->radius();
+    if (std::find(m_pursuers.begin(), m_pursuers.end(), o) !=
+        m_pursuers.end())
+      flags[i] |= Snapshot::BIG_BALL;
+
+    target[i] = -1;
+    for (map_globject::const_iterator it = m_targets.begin();
+         it != m_targets.end(); it++)
+      if ((*it).second == o) target[i] = (*it).first;
+
+    vec_victims::const_iterator v =
+      std::find(m_victims.begin(), m_victims.end(), o);
+    victim[i] = (v == m_victims.end() ? -1 : (v - m_victims.begin()));
+
+    const Transform& tr = o->transform();
+    for (int k = 0; k < 3; k++) {
+      position[i*3 + k] = m_origin[k] + tr.translation()[k];
+      velocity[i*3 + k] = o->velocity()[k];
+      scaling [i*3 + k] = tr.scaling()[k];
+    }
+    for (int k = 0; k < 16; k++)
+      rotation[i*16 + k] = tr.rotation().array()[k];
+  }
+
+  return snap.save(i_file);
+}
+
+// -------------------------------------------------------------------------
+// loadSnapshot(file) : replace the whole scene by a saved one
+//
+// notes        : the snapshot arrays are read in place from the mapped
+//                file. textures are not saved, the ones referenced must
+//                be generated the same way by this scene.
+// return value : 'false' if the file isn't a valid snapshot
+// -------------------------------------------------------------------------
+
+bool Scene::loadSnapshot(const QString& i_file)
+{
+  Snapshot snap;
+  if (!snap.map(i_file)) return false;
+  const SnapshotHeader& h = snap.header();
+
+  // bodies are either sheep or balls, of a real size, and victims are
+  // numbered among them
+  const qint32* kind   = (const qint32*)snap.array(Snapshot::KIND);
+  const qint32* victim = (const qint32*)snap.array(Snapshot::VICTIM);
+  const double* size   = (const double*)snap.array(Snapshot::SIZE);
+  for (unsigned int i = 0; i < h.bodies; i++) {
+    if ((kind[i] != Snapshot::SHEEP) && (kind[i] != Snapshot::BALL)) {
+      qWarning("snapshot : unknown body kind %d", (int)kind[i]);
+      return false;
+    }
+    if (!(size[i] > 0.) || !(size[i] < HUGE_VAL)) {
+      qWarning("snapshot : invalid body size %g", size[i]);
+      return false;
+    }
+    if (victim[i] >= (qint32)h.bodies) {
+      qWarning("snapshot : victim %d out of range", (int)victim[i]);
+      return false;
+    }
+  }
+
+  // the scene is rebuilt from scratch
+  clear();
+  {
+    SceneParameters params = m_params;
+    params.seed         = h.seed;
+    params.limitGrass   = h.limitGrass;
+    params.bigBallAccel = h.bigBallAccel;
+    params.worldRadius  = h.worldRadius;
+    params.maximumSheep = h.maximumSheep;
+    params.restitution  = h.restitution;
+    params.friction     = h.friction;
+    params.solverIterations = h.solverIterations;
+    params.spawnPoint   = Vector(h.spawnPoint[0], h.spawnPoint[1],
+                                 h.spawnPoint[2]);
+    setParameters(params);
+  }
+  m_stats.seconds       = h.seconds;
+  m_stats.timeSurvived  = h.timeSurvived;
+  m_stats.collisions    = h.collisions;
+  m_stats.victimsHit    = h.victimsHit;
+  m_stats.sheep         = h.sheepCounter;
+  m_sheep_counter       = h.sheepCounter;
+  m_evil_big_ball       = (h.evilBigBall != 0);
+  m_random.setState(h.random);
+
+  const quint64* hashes = (const quint64*)snap.array(Snapshot::TEXTURE_HASH);
+  const qint32* flags    = (const qint32*)snap.array(Snapshot::FLAGS);
+  const qint32* target   = (const qint32*)snap.array(Snapshot::TARGET);
+  const qint32* texture  = (const qint32*)snap.array(Snapshot::TEXTURE);
+  const double* position = (const double*)snap.array(Snapshot::POSITION);
+  const double* velocity = (const double*)snap.array(Snapshot::VELOCITY);
+  const double* rotation = (const double*)snap.array(Snapshot::ROTATION);
+  const double* scaling  = (const double*)snap.array(Snapshot::SCALING);
+  const double* phase    = (const double*)snap.array(Snapshot::PHASE);
+  const double* orient   = (const double*)snap.array(Snapshot::ORIENTATION);
+
+  // texture references are matched against this scene textures
+  std::vector<quint64> known;
+  for (unsigned int t = 0; t < m_textures.size(); t++)
+    known.push_back(m_textures[t]->hash());
+
+  bool wool_checked = false;
+  for (unsigned int i = 0; i < h.bodies; i++) {
+    Globject* o = 0;
+    Sheep* sheep = 0;
+    Ball*  ball  = 0;
+    if (kind[i] == Snapshot::SHEEP) o = sheep = new Sheep(size[i]);
+    else                            o = ball  = new Ball(size[i]);
+
+    o->setMovable((flags[i] & Snapshot::MOVABLE) != 0);
+    o->transform().setTranslation
+      (Vector(position[i*3], position[i*3 + 1], position[i*3 + 2]));
+    o->transform().setScaling
+      (Vector(scaling[i*3], scaling[i*3 + 1], scaling[i*3 + 2]));
+    Matrix rot; rot.set(rotation + i*16);
+    o->transform().setRotation(rot);
+    o->setVelocity
+      (Vector(velocity[i*3], velocity[i*3 + 1], velocity[i*3 + 2]));
+
+    if (sheep) {
+      sheep->setAnimator(&m_animator);
+      sheep->setAnimationState(phase[i], orient[i],
+                               (flags[i] & Snapshot::WALKING) != 0,
+                               (flags[i] & Snapshot::WAITING) != 0);
+
+      // the wool is generated by the sheep, it should not have changed
+      if (!wool_checked && (texture[i] >= 0) &&
+          ((quint32)texture[i] < h.textures)) {
+        wool_checked = true;
+        if (hashes[texture[i]] != Sheep::sp_wool->hash())
+          qWarning("snapshot : the wool texture has changed");
+      }
+    }
+
+    if (ball && (texture[i] >= 0) && ((quint32)texture[i] < h.textures)) {
+      std::vector<quint64>::iterator t =
+        std::find(known.begin(), known.end(), hashes[texture[i]]);
+      if (t != known.end())
+        ball->setTexture(m_textures[t - known.begin()]);
+      else
+        qWarning("snapshot : unknown texture %llx",
+                 (unsigned long long)hashes[texture[i]]);
+    }
+
+    addChild(o);
+    m_grid.insert(o);
+    if (target[i] >= 0) {
+      m_targets.insert(map_globject::value_type(target[i], o));
+      if (target[i] >= m_nextTargetId) m_nextTargetId = target[i] + 1;
+    }
+    if (victim[i] >= 0) {
+      if ((int)m_victims.size() <= victim[i])
+        m_victims.resize(victim[i] + 1, 0);
+      m_victims[victim[i]] = o;
+    }
+    if (flags[i] & Snapshot::BIG_BALL) {
+      m_pursuers.push_back(o);
+      if (!mp_big_ball) mp_big_ball = o;
+    }
+  }
+
+  // the victims must all be there (the paged out ones aren't saved, but
+  // they still count against the maximum)
+  if (std::find(m_victims.begin(), m_victims.end(), (Globject*)0) !=
+      m_victims.end() || ((int)m_victims.size() > m_sheep_counter)) {
+    qWarning("snapshot : inconsistent victims");
+    m_victims.erase(std::remove(m_victims.begin(), m_victims.end(),
+                                (Globject*)0), m_victims.end());
+    if ((int)m_victims.size() > m_sheep_counter)
+      m_sheep_counter = m_victims.size();
+  }
+  for (unsigned int v = 0; v < m_victims.size(); v++)
+    m_herd.insert(m_victims[v]);
+
+  // the contact solver starts warm, as it was
+  {
+    const qint32* pair    = (const qint32*)snap.array(Snapshot::CONTACT_PAIR);
+    const double* impulse =
+      (const double*)snap.array(Snapshot::CONTACT_IMPULSE);
+    const vec_globject& objs = children();
+    ContactSolver::vec_impulses impulses;
+    for (unsigned int c = 0; c < h.contacts; c++) {
+      qint32 a = pair[c*2], b = pair[c*2 + 1];
+      if ((a < 0) || (a >= (qint32)h.bodies) ||
+          (b < -1) || (b >= (qint32)h.bodies))
+        continue;
+      ContactSolver::Impulse imp;
+      imp.a       = objs[a];
+      imp.b       = (b >= 0 ? objs[b] : 0);
+      imp.normal  = impulse[c*4];
+      imp.tangent = Vector(impulse[c*4 + 1], impulse[c*4 + 2],
+                           impulse[c*4 + 3]);
+      impulses.push_back(imp);
+
+      // the victims still touching a Big Red Ball were hit already (the
+      // impulses are the contacts of the last tick, see updateStats)
+      if (b < 0) continue;
+      Globject* other = 0;
+      if (std::find(m_pursuers.begin(), m_pursuers.end(), objs[a]) !=
+          m_pursuers.end())
+        other = objs[b];
+      else if (std::find(m_pursuers.begin(), m_pursuers.end(), objs[b]) !=
+               m_pursuers.end())
+        other = objs[a];
+      if (other && m_herd.contains(other) &&
+          (std::find(m_touched.begin(), m_touched.end(), other) ==
+           m_touched.end()))
+        m_touched.push_back(other);
+    }
+    m_solver.setImpulses(impulses);
+  }
+
+  // pose and sort all the restored bodies
+  m_animator.update();
+  m_grid.update(mp_scheduler);
+  m_herd.update(mp_scheduler);
+  m_hierarchy.update(children(), mp_scheduler);
+  updateAtlas();
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// updateStats(seconds) : account for the collisions of the last tick
+//
+// notes : a victim is hit when it starts touching a Big Red Ball, it
+//         will not be hit again before the two objects are apart
+// -------------------------------------------------------------------------
+
+void Scene::updateStats(double i_sec)
+{
+  m_stats.seconds   += i_sec;
+  m_stats.sheep      = m_sheep_counter;
+  m_stats.collisions += (int)m_contacts.size();
+
+  vec_victims touching;
+  for (Physics::vec_contacts::const_iterator it = m_contacts.begin();
+       it != m_contacts.end(); it++) {
+    Globject* other = 0;
+    if (std::find(m_pursuers.begin(), m_pursuers.end(), (*it).first) !=
+        m_pursuers.end())
+      other = (*it).second;
+    else if (std::find(m_pursuers.begin(), m_pursuers.end(), (*it).second) !=
+             m_pursuers.end())
+      other = (*it).first;
+    if (!other || !m_herd.contains(other))
+      continue;
+
+    if (std::find(touching.begin(), touching.end(), other) ==
+        touching.end())
+      touching.push_back(other);
+
+    // BANG! is it the first time?
+    if (std::find(m_touched.begin(), m_touched.end(), other) ==
+        m_touched.end())
+      m_stats.victimsHit++;
+  }
+  m_touched.swap(touching);
+
+  // the herd survives as long as no sheep has been hit
+  if (m_stats.victimsHit == 0)
+    m_stats.timeSurvived = m_stats.seconds;
+}
+
+// -------------------------------------------------------------------------
+// addTarget(globject) : add an interesting target (for the camera)
+//
+// notes : targets are numbered in the order they are added
+// -------------------------------------------------------------------------
+
 void Scene::addTarget(const Globject* t)
 {
   m_targets.insert(map_globject::value_type(m_nextTargetId++, t));
@@ -157,30 +1325,86 @@ void Scene::addTarget(const Globject* t)
 
 void Scene::globject_draw(QGLWidget* i_gl)
 {
+  // remember what was drawn (see moved)
+  const vec_globject& objs = children();
+  m_drawn.resize(objs.size());
+  for (unsigned int i = 0; i < objs.size(); i++)
+    m_drawn[i] = pose(objs[i]);
+
   // push current opengl states
   glPushAttrib(GL_CURRENT_BIT | GL_LIGHTING_BIT);
 
   // turn off lighting : we can't afford to use it here
+  bool shaded = LightingShader::end();
   glDisable(GL_LIGHTING);
 
   // wool texture from sheep makes great grass
   Texture::pushAttrib();
-  Sheep::sp_wool->bind(i_gl);
+  if (Sheep::sp_wool) Sheep::sp_wool->bind(i_gl);
 
   // grass field
-  glBegin(GL_TRIANGLE_STRIP);
   glColor3d(0.0, 0.7, 0.0);
-  glTexCoord2d(0., 0.);
-  glVertex3d(-LIMIT_GRASS, 0., -LIMIT_GRASS);
-  glTexCoord2d(0., 1.);
-  glVertex3d(-LIMIT_GRASS, 0.,  LIMIT_GRASS);
-  glTexCoord2d(1., 0.);
-  glVertex3d( LIMIT_GRASS, 0., -LIMIT_GRASS);
-  glTexCoord2d(1., 1.);
-  glVertex3d( LIMIT_GRASS, 0.,  LIMIT_GRASS);
-  glEnd();
+  m_terrain.draw();
+
+  // shadows of the movable objects on the grass
+  drawShadows(i_gl);
 
   // pop back previous opengl states
   Texture::popAttrib();
   glPopAttrib();
+  if (shaded) LightingShader::begin();
+}
+
+// -------------------------------------------------------------------------
+// drawShadows(gl) : blob shadows under the movable objects
+//
+// notes : a shadow is a textured quad on the floor (y = 0) under the
+//         bounding sphere, fading out as the object gets higher. all the
+//         shadows are drawn at once, from the stream buffer.
+// -------------------------------------------------------------------------
+
+void Scene::drawShadows(QGLWidget* i_gl)
+{
+  m_shadows.clear();
+  const vec_globject& objs = children();
+  for (vec_globject::const_iterator it = objs.begin();
+       it != objs.end(); it++) {
+    if (!(*it)->movable()) continue;
+
+    BoundingSphere bs = (*it)->boundingSphere();
+    double r = bs.radius();
+    double height = bs.center().y() - r;
+    if (!(r > 0.)) continue;
+
+    double fade = 1. - (height > 0. ? height : 0.) / (SHADOW_FADE * r);
+    if (fade <= 0.) continue;
+
+    double x = bs.center().x(), z = bs.center().z(), size = r * SHADOW_SIZE;
+    if (!m_terrain.contains(x, z)) continue;
+
+    GLubyte a = (GLubyte)(255. * SHADOW_ALPHA * fade);
+    ShadowVertex v[4] = {
+      { 0., 0., 0, 0, 0, a, (GLfloat)(x - size), 0., (GLfloat)(z - size) },
+      { 0., 1., 0, 0, 0, a, (GLfloat)(x - size), 0., (GLfloat)(z + size) },
+      { 1., 1., 0, 0, 0, a, (GLfloat)(x + size), 0., (GLfloat)(z + size) },
+      { 1., 0., 0, 0, 0, a, (GLfloat)(x + size), 0., (GLfloat)(z - size) } };
+    m_shadows.insert(m_shadows.end(), v, v + 4);
+  }
+  if (m_shadows.empty()) return;
+
+  // blended over the grass, just in front of it
+  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+               GL_POLYGON_BIT | GL_ENABLE_BIT);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(-1., -1.);
+
+  Texture::pushAttrib();
+  mp_blob->bind(i_gl);
+  m_stream.draw(GL_QUADS, GL_T2F_C4UB_V3F, &m_shadows[0], m_shadows.size());
+  Texture::popAttrib();
+
+  glPopAttrib();
 }
@@ -24,21 +24,98 @@
 class   Scene;
 
 class Texture;
+class Sheep;
+class Ball;
+class QString;
+class Ray;
+class Scheduler;
+#include "boundinghierarchy.h"
+#include "contactsolver.h"
+#include "flock.h"
 #include "globject.h"
+#include "matrix.h"
+#include "memorystats.h"
+#include "physics.h"
+#include "random.h"
+#include "sheepanimator.h"
+#include "spatialgrid.h"
+#include "streambuffer.h"
+#include "terrain.h"
+#include "textureatlas.h"
+#include "worldpager.h"
 #include <map>
 #include <vector>
 
+struct SceneParameters
+//
+// SceneParameters : scene tunables, all of them can be set at runtime
+//
+{
+  SceneParameters();
+
+  quint64 seed;          // scene random generator seed
+  int     maximumSheep;  // how many sheep will we have to protect?
+  double  limitGrass;    // where does the field of grass end? (m)
+  double  bigBallAccel;  // Big Red Ball acceleration (m/s^2)
+  double  worldRadius;   // radius of the sphere the world is in (m)
+  Vector  spawnPoint;    // where do the new sheep come from?
+  double  restitution;   // velocity kept by bounces (see ContactSolver)
+  double  friction;      // friction between bodies
+  int     solverIterations; // contact solver iterations per step
+  double  cellSize;      // world paged by cells (m, 0 -> no paging)
+};
+
+struct SceneStats
+//
+// SceneStats : what happened in the scene so far (herd survival metrics)
+//
+{
+  SceneStats();
+
+  double seconds;       // simulated time (s)
+  int    sheep;         // sheep spawned so far
+  int    collisions;    // collisions between objects of the scene
+  int    victimsHit;    // times the Big Red Ball hit one of the sheep
+  double timeSurvived;  // time before the first sheep was hit (s)
+};
+
 class Scene : public Globject
 //
 // Scene : main opengl scene, a green valley with sheep
 //
 {
  public:
-  Scene();
+  Scene(const SceneParameters& i_params = SceneParameters());
   virtual ~Scene();
 
+  // run the steps on a scheduler (0 -> on the calling thread only)
+  void setScheduler(Scheduler* i_scheduler);
+
   // new frame tick (true -> the scene needs to be redrawn)
   bool tick(int i_ms);
+  bool step(double i_sec);
+
+  // draw between the last two steps (alpha : 0 -> previous, 1 -> last),
+  // children are moved back to the last step by endInterpolation()
+  void beginInterpolation(double i_alpha);
+  void endInterpolation();
+
+  // where the world is looked at from (the camera target) : with
+  // paging, the cells around it are loaded (see WorldPager)
+  void setFocus(const Vector& i_focus);
+
+  // where the scene is in the world : the children positions, the focus
+  // and the spatial queries are relative to this origin, which follows
+  // the focus in a paged world (floating origin)
+  const Vector& origin() const;
+
+  // hide the children out of the opengl view volume until
+  // endInterpolation(), animate the far away sheep less often
+  // (the camera must be placed)
+  void cull();
+
+  // did anything move visibly since the scene was last drawn?
+  bool moved() const;
 
   // is the big ball evil? (wants to attack the sheep)
   void setEvilBigBall(bool i_evil);
@@ -46,8 +123,44 @@ class Scene : public Globject
   // access to interesting scene targets
   const Globject* target(int i_id) const;
 
+  // spatial queries on the children bounding spheres, as of the last step
+  // (victims : only among the sheep to protect), see SpatialGrid
+  int nearest(const Vector& i_point, int i_count, vec_globject& o_found,
+              bool i_victims = false) const;
+  int within(const Vector& i_point, double i_radius,
+             vec_globject& o_found) const;
+
+  // first child on a ray (mouse selection), see BoundingHierarchy
+  Globject* pick(const Ray& i_ray, double* o_distance = 0) const;
+
+  // scene pseudo-random number generator
+  Random& random();
+
+  // scene tunables and herd survival metrics
+  const SceneParameters& parameters() const;
+  void setParameters(const SceneParameters& i_params);
+  const SceneStats& stats() const;
+
+  // live objects and bytes by type, with their peaks (for the whole
+  // process : scenes share textures, see MemoryStats)
+  MemoryStats memoryStats() const;
+
+  // scene building : remove everything, add sheep, balls and targets
+  void   clear();
+  Sheep* addSheep(double i_size, bool i_victim);
+  Ball*  addBall(double i_radius, bool i_big_ball);
+  void   addTarget(const Globject* t);
+
+  // save / restore the whole scene state (see Snapshot)
+  bool saveSnapshot(const QString& i_file) const;
+  bool loadSnapshot(const QString& i_file);
+
  protected:
-  void addTarget(const Globject* t);
+  void updateStats(double i_sec);
+  void pursue();
+  void page();
+  void rebase();
+  void setOrigin(const Vector& i_origin);
   virtual void globject_draw(QGLWidget* i_gl);
 
  private:
@@ -55,14 +168,75 @@ class Scene : public Globject
   typedef std::vector<Texture*>          vec_textures;
   typedef std::vector<Globject*>         vec_victims;
 
+  struct DrawnPose
+  //
+  // DrawnPose : how a child looked when the scene was last drawn
+  //
+  {
+    const Globject* object;
+    Vector position;
+    Matrix rotation;
+    double phase;        // sheep only
+    double orientation;
+    bool   waiting;
+  };
+  typedef std::vector<DrawnPose>         vec_poses;
+  typedef std::vector<Vector>            vec_positions;
+  typedef std::vector<char>              vec_flags;
+
+  static DrawnPose pose(const Globject* i_object);
+  bool isTarget(const Globject* i_object) const;
+  void storeBody(const Globject* i_object, WorldPager::Body& o_body) const;
+  void restoreBody(const WorldPager::Body& i_body);
+  void removeBody(Globject* i_object);
+  void updateAtlas();
+  void drawShadows(QGLWidget* i_gl);
+
+  struct ShadowVertex
+  //
+  // ShadowVertex : blob shadow corner (GL_T2F_C4UB_V3F)
+  //
+  {
+    GLfloat s, t;
+    GLubyte r, g, b, a;
+    GLfloat x, y, z;
+  };
+  typedef std::vector<ShadowVertex>      vec_shadows;
+
+  Scheduler*   mp_scheduler;      // 0 -> steps on the calling thread
+  SceneParameters m_params;       // scene tunables
+  SceneStats   m_stats;           // herd survival metrics
   map_globject m_targets;         // available targets
   int          m_nextTargetId;    // next new target will get this id
   vec_textures m_textures;        // all textures used in the scene
+  TextureAtlas m_atlas;           // the same, packed in one texture
+  Terrain      m_terrain;         // the field of grass
+  vec_shadows  m_shadows;         // blob shadows of the current frame
+  StreamBuffer m_stream;          // per frame geometry
   int          m_sheep_counter;   // how many sheep to protect?
   vec_victims  m_victims;         // vector of sheep to attack
-  int          m_current_victim;  // current victim for the Big Red Ball
+  SpatialGrid  m_grid;            // all the children, by position
+  SpatialGrid  m_herd;            // the victims only
+  BoundingHierarchy m_hierarchy;  // all the children, for rays
+  vec_victims  m_pursuers;        // balls attacking the nearest victim
+  Flock        m_flock;           // herd behaviour of the victims
   Globject*    mp_big_ball;       // pointer to the Big Red Ball
+  Texture*     mp_checkered;      // Big Red Ball texture
+  Texture*     mp_blob;           // blob shadow texture
   bool         m_evil_big_ball;   // is the Big Red Ball possessed?
+  Random       m_random;          // scene own random number generator
+  vec_victims  m_touched;         // victims touching the Big Red Ball
+  Physics::vec_contacts m_contacts; // collisions during the last tick
+  ContactSolver m_solver;         // collisions between the children
+  SheepAnimator m_animator;       // poses all the sheep at once
+  vec_poses    m_drawn;           // children poses when last drawn
+  vec_positions m_previous;       // children positions before last step
+  vec_positions m_current;        // children positions while interpolating
+  vec_flags    m_inside;          // children in the view volume (see cull)
+  vec_globject m_culled;          // children hidden by cull
+  Vector       m_origin;          // of the scene, in the world
+  Vector       m_focus;           // the world is loaded around it
+  WorldPager   m_pager;           // cells of the world, paged to disk
 };
 
 #endif // SCENE_H
@@ -0,0 +1,318 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "sceneloader.h"
+#include "scene.h"
+#include "sheep.h"
+#include "ball.h"
+#include "transform.h"
+#include "vector.h"
+#include <QFile>
+#include <QIODevice>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define LINE_SIZE  1024           // longest line accepted
+#define HERD_SIZE  (0.70 * 0.75)  // herd sheep are 3/4 the size of our hero
+#define HERD_MAX   1000000        // more sheep than that is a typo
+
+SceneLoader::SceneLoader()
+  :mp_cursor(0),
+   m_line(0),
+   m_error()
+{
+}
+
+// -------------------------------------------------------------------------
+// load(file, scene) : replace the scene by the one described in 'file'
+//
+// notes        : the scene is left untouched if the file can't be read,
+//                and empty if the description is invalid
+// return value : 'false' if it fails (see errorString)
+// -------------------------------------------------------------------------
+
+bool SceneLoader::load(const QString& i_file, Scene& o_scene)
+{
+  QFile f(i_file);
+  if (!f.open(QIODevice::ReadOnly)) {
+    m_line = 0;
+    return error("can't open the scene file");
+  }
+  return load(f, o_scene);
+}
+
+bool SceneLoader::load(QIODevice& i_device, Scene& o_scene)
+{
+  char line[LINE_SIZE];
+  qint64 length;
+  SceneParameters params;
+
+  m_error = QString();
+  m_line  = 0;
+  o_scene.clear();
+
+  while ((length = i_device.readLine(line, sizeof(line))) > 0) {
+    m_line++;
+    if ((line[length - 1] != '\n') && !i_device.atEnd()) {
+      o_scene.clear();
+      return error("line too long");
+    }
+    if (!parseLine(line, o_scene, params)) {
+      o_scene.clear();
+      return false;
+    }
+  }
+
+  o_scene.setParameters(params);
+  return true;
+}
+
+const QString& SceneLoader::errorString() const
+{
+  return m_error;
+}
+
+// -------------------------------------------------------------------------
+// parseLine(line, scene, params) : one directive (see sceneloader.h)
+// -------------------------------------------------------------------------
+
+bool SceneLoader::parseLine(char* i_line, Scene& o_scene,
+                            SceneParameters& o_params)
+{
+  mp_cursor = i_line;
+  const char* key = token();
+
+  // empty line or comment
+  if (!key) return true;
+
+  if (!strcmp(key, "sheep")) return parseSheep(o_scene);
+  if (!strcmp(key, "ball"))  return parseBall(o_scene);
+  if (!strcmp(key, "herd"))  return parseHerd(o_scene);
+
+  bool ok = true;
+  double v = 0.;
+  if      (!strcmp(key, "seed"))           ok = integer(o_params.seed);
+  else if (!strcmp(key, "limit_grass"))    ok = number(o_params.limitGrass);
+  else if (!strcmp(key, "big_ball_accel")) ok = number(o_params.bigBallAccel);
+  else if (!strcmp(key, "world_radius"))   ok = number(o_params.worldRadius);
+  else if (!strcmp(key, "restitution"))    ok = number(o_params.restitution);
+  else if (!strcmp(key, "friction"))       ok = number(o_params.friction);
+  else if (!strcmp(key, "cell_size"))      ok = number(o_params.cellSize);
+  else if (!strcmp(key, "solver_iterations")) {
+    ok = number(v) && (v >= 1.);
+    o_params.solverIterations = (int)v;
+  }
+  else if (!strcmp(key, "maximum_sheep")) {
+    ok = number(v) && (v >= 0.);
+    o_params.maximumSheep = (int)v;
+  }
+  else if (!strcmp(key, "spawn")) {
+    double x, y, z;
+    ok = number(x) && number(y) && number(z);
+    o_params.spawnPoint = Vector(x, y, z);
+  }
+  else return error("unknown directive");
+
+  if (!ok)     return error("invalid value");
+  if (token()) return error("unexpected value at the end of the line");
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// parseSheep(scene) : sheep SIZE X Y Z [rotate DEG AX AY AZ]... [hero]
+//                           [target]
+// -------------------------------------------------------------------------
+
+bool SceneLoader::parseSheep(Scene& o_scene)
+{
+  double size, x, y, z;
+  if (!number(size) || !number(x) || !number(y) || !number(z) ||
+      (size <= 0.))
+    return error("sheep : SIZE X Y Z expected");
+
+  // options are read before the sheep is added (hero or not?)
+  bool   hero = false, target = false;
+  double rotations[4 * 8];
+  int    count = 0;
+  for (const char* t = token(); t; t = token()) {
+    if (!strcmp(t, "rotate")) {
+      if (count == 8) return error("sheep : too many rotations");
+      double* r = rotations + (count++) * 4;
+      if (!number(r[0]) || !number(r[1]) || !number(r[2]) || !number(r[3]))
+        return error("sheep : rotate DEGREES AX AY AZ expected");
+    }
+    else if (!strcmp(t, "hero"))   hero   = true;
+    else if (!strcmp(t, "target")) target = true;
+    else return error("sheep : unknown option");
+  }
+
+  Sheep* sheep = o_scene.addSheep(size, !hero);
+  sheep->transform().setTranslation(Vector(x, y, z));
+  for (int i = 0; i < count; i++) {
+    double* r = rotations + i * 4;
+    sheep->transform().addRotation(r[0], Vector(r[1], r[2], r[3]));
+  }
+  if (target) o_scene.addTarget(sheep);
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// parseBall(scene) : ball RADIUS X Y Z [big] [target]
+// -------------------------------------------------------------------------
+
+bool SceneLoader::parseBall(Scene& o_scene)
+{
+  double radius, x, y, z;
+  if (!number(radius) || !number(x) || !number(y) || !number(z) ||
+      (radius <= 0.))
+    return error("ball : RADIUS X Y Z expected");
+
+  bool big = false, target = false;
+  for (const char* t = token(); t; t = token()) {
+    if      (!strcmp(t, "big"))    big    = true;
+    else if (!strcmp(t, "target")) target = true;
+    else return error("ball : unknown option");
+  }
+
+  Ball* ball = o_scene.addBall(radius, big);
+  ball->transform().setTranslation(Vector(x, y, z));
+  if (target) o_scene.addTarget(ball);
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// parseHerd(scene) : herd COUNT grid SPACING X Y Z [size SIZE]
+//                    herd COUNT disc RADIUS  X Y Z [size SIZE]
+//
+// notes : on a disc, sheep are placed on a sunflower spiral, which
+//         spreads them evenly without any random number
+// -------------------------------------------------------------------------
+
+bool SceneLoader::parseHerd(Scene& o_scene)
+{
+  double count, extent, x, y, z, size = HERD_SIZE;
+  const char* mode = 0;
+  if (!number(count) || !(mode = token()) || !number(extent) ||
+      !number(x) || !number(y) || !number(z) ||
+      (count < 0.) || (count > HERD_MAX) || (extent < 0.))
+    return error("herd : COUNT grid|disc EXTENT X Y Z expected");
+
+  bool grid = !strcmp(mode, "grid");
+  if (!grid && strcmp(mode, "disc"))
+    return error("herd : grid or disc expected");
+
+  for (const char* t = token(); t; t = token()) {
+    if (!strcmp(t, "size")) {
+      if (!number(size) || (size <= 0.))
+        return error("herd : size SIZE expected");
+    }
+    else return error("herd : unknown option");
+  }
+
+  int n = (int)count;
+  int side = (int)ceil(sqrt((double)n));
+  double golden_angle = M_PI * (3. - sqrt(5.));
+
+  for (int i = 0; i < n; i++) {
+    double dx, dz;
+    if (grid) {
+      dx = ((i % side) - (side - 1) / 2.) * extent;
+      dz = ((i / side) - (side - 1) / 2.) * extent;
+    }
+    else {
+      double r = extent * sqrt((i + 0.5) / n);
+      double a = i * golden_angle;
+      dx = r * cos(a);
+      dz = r * sin(a);
+    }
+    Sheep* sheep = o_scene.addSheep(size, true);
+    sheep->transform().setTranslation(Vector(x + dx, y, z + dz));
+  }
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// token() : next word of the line, null terminated in place
+//
+// return value : 0 at the end of the line or at the start of a comment
+// -------------------------------------------------------------------------
+
+char* SceneLoader::token()
+{
+  char* p = mp_cursor;
+  while (*p && isspace((unsigned char)*p)) p++;
+  if (!*p || (*p == '#')) {
+    mp_cursor = p;
+    return 0;
+  }
+
+  char* start = p;
+  while (*p && !isspace((unsigned char)*p) && (*p != '#')) p++;
+  if (*p == '#') {
+    // the comment starts right after the word : the line ends here
+    *p = 0;
+    mp_cursor = p;
+  }
+  else if (*p) {
+    *p = 0;
+    mp_cursor = p + 1;
+  }
+  else mp_cursor = p;
+  return start;
+}
+
+bool SceneLoader::number(double& o_value)
+{
+  const char* t = token();
+  if (!t) return false;
+
+  char* end = 0;
+  double v = strtod(t, &end);
+  if (*end || (v != v)) return false;
+  o_value = v;
+  return true;
+}
+
+bool SceneLoader::integer(quint64& o_value)
+{
+  const char* t = token();
+  if (!t || (*t == '-')) return false;
+
+  char* end = 0;
+  quint64 v = strtoull(t, &end, 10);
+  if (*end) return false;
+  o_value = v;
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// error(message) : remember what went wrong
+//
+// return value : always 'false'
+// -------------------------------------------------------------------------
+
+bool SceneLoader::error(const char* i_message)
+{
+  m_error = QString("line %1 : %2").arg(m_line).arg(i_message);
+  return false;
+}
@@ -0,0 +1,96 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+class   SceneLoader;
+
+class Scene;
+struct SceneParameters;
+class QIODevice;
+#include <QString>
+#include <QtGlobal>
+
+class SceneLoader
+//
+// SceneLoader : load a scene description file into a Scene
+//
+//   the file is read line by line, '#' starts a comment :
+//
+//     seed            N          scene tunables (see SceneParameters)
+//     maximum_sheep   N
+//     limit_grass     METERS
+//     big_ball_accel  M/S^2
+//     world_radius    METERS
+//     restitution     0..1       bounces (see ContactSolver)
+//     friction        RATIO
+//     solver_iterations N
+//     cell_size       METERS     world paged around the camera, by cells
+//                                (0 : none, see WorldPager)
+//     spawn           X Y Z      where do the new sheep come from
+//
+//     sheep  SIZE X Y Z [rotate DEGREES AX AY AZ]... [hero] [target]
+//     ball   RADIUS X Y Z [big] [target]
+//     herd   COUNT grid SPACING X Y Z [size SIZE]
+//     herd   COUNT disc RADIUS  X Y Z [size SIZE]
+//
+//   hero   : the sheep isn't part of the herd to protect
+//   big    : the ball is a Big Red Checkered Ball, after the nearest sheep
+//            (the first one is the Big Red Ball, see Scene::addBall)
+//   target : the camera can follow the body (targets are numbered in
+//            the order they appear : 0 is followed first, right click
+//            switches to 1)
+//   herd   : COUNT sheep to protect, on a square grid or evenly spread
+//            on a disc (sunflower pattern), around X Y Z
+//
+//   the loader works in place in a fixed line buffer, there is no
+//   allocation per token, and the load time is linear.
+//
+{
+ public:
+  SceneLoader();
+
+  // replace the scene by the one described ('false' if it fails)
+  bool load(const QString& i_file, Scene& o_scene);
+  bool load(QIODevice& i_device, Scene& o_scene);
+
+  // what went wrong? (with the line number)
+  const QString& errorString() const;
+
+ private:
+  bool parseLine(char* i_line, Scene& o_scene, SceneParameters& o_params);
+  bool parseSheep(Scene& o_scene);
+  bool parseBall(Scene& o_scene);
+  bool parseHerd(Scene& o_scene);
+
+  // in place tokenizer (returns 0 at the end of the line)
+  char* token();
+  bool  number(double& o_value);
+  bool  integer(quint64& o_value);
+
+  bool error(const char* i_message);
+
+  char*   mp_cursor; // current position in the line
+  int     m_line;    // current line number
+  QString m_error;   // last error
+};
+
+#endif // SCENELOADER_H
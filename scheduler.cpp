@@ -0,0 +1,347 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "scheduler.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <algorithm>
+
+// how long an idle thread sleeps before looking for work again (ms)
+#define IDLE_TIMEOUT 10
+
+// a loop is split in a few chunks per thread, so the threads done first
+// can steal from the others
+#define CHUNKS_PER_THREAD 4
+
+Job::Job()
+  :m_finished(true)
+{
+}
+
+Job::~Job()
+{
+}
+
+Loop::~Loop()
+{
+}
+
+// -------------------------------------------------------------------------
+// Chunk : iterations of a loop, run as one job (see parallelFor)
+// -------------------------------------------------------------------------
+
+class Chunk : public Job
+{
+ public:
+  Chunk(Loop* i_body, int i_begin, int i_end)
+    :Job(), mp_body(i_body), m_begin(i_begin), m_end(i_end) {}
+
+  virtual void run() { mp_body->run(m_begin, m_end); }
+
+ private:
+  Loop* mp_body;
+  int   m_begin, m_end;
+};
+
+// -------------------------------------------------------------------------
+// Scheduler::Worker : worker thread owning a deque of jobs
+// -------------------------------------------------------------------------
+
+class Scheduler::Worker : public QThread
+{
+ public:
+  Worker(Scheduler* i_scheduler, int i_id)
+    :QThread(), mp_scheduler(i_scheduler), m_id(i_id) {}
+
+  QMutex   m_mutex; // protects the deque
+  deq_jobs m_jobs;  // jobs owned by this worker
+
+ protected:
+  virtual void run();
+
+ private:
+  Scheduler* mp_scheduler;
+  int        m_id;
+};
+
+void Scheduler::Worker::run()
+{
+  for (;;) {
+    Job* job = mp_scheduler->take(m_id);
+    if (job) {
+      mp_scheduler->execute(job, m_id);
+      continue;
+    }
+
+    // nothing to do : sleep until a job is submitted
+    QMutexLocker lock(&mp_scheduler->m_mutex);
+    if (mp_scheduler->m_quit) return;
+    if (mp_scheduler->m_queued == 0)
+      mp_scheduler->m_work.wait(&mp_scheduler->m_mutex, IDLE_TIMEOUT);
+  }
+}
+
+// -------------------------------------------------------------------------
+// Scheduler(workers) : start the worker threads
+// -------------------------------------------------------------------------
+
+Scheduler::Scheduler(int i_workers)
+  :m_workers(),
+   m_mutex(),
+   m_work(),
+   m_done(),
+   m_queued(0),
+   m_pending(0),
+   m_next(0),
+   m_quit(false),
+   m_busy()
+{
+  if (i_workers <= 0) i_workers = QThread::idealThreadCount();
+  if (i_workers <= 0) i_workers = 1;
+  m_busy.assign(i_workers + 1, 0);
+
+  for (int i = 0; i < i_workers; i++)
+    m_workers.push_back(new Worker(this, i));
+  for (int i = 0; i < i_workers; i++)
+    m_workers[i]->start();
+}
+
+Scheduler::~Scheduler()
+{
+  wait();
+  {
+    QMutexLocker lock(&m_mutex);
+    m_quit = true;
+    m_work.wakeAll();
+  }
+  // workers may still look into each other's deque until they all stop
+  for (vec_workers::iterator it = m_workers.begin();
+       it != m_workers.end(); it++)
+    (*it)->wait();
+  for (vec_workers::iterator it = m_workers.begin();
+       it != m_workers.end(); it++) {
+    delete (*it); (*it) = 0;
+  }
+  m_workers.clear();
+}
+
+int Scheduler::workers() const
+{
+  return (int)m_workers.size();
+}
+
+// -------------------------------------------------------------------------
+// submit(job) : add a job to be run by one of the workers
+//
+// notes : a job submitted from a worker thread goes to that worker's
+//         deque
+// -------------------------------------------------------------------------
+
+void Scheduler::submit(Job* i_job)
+{
+  if (!i_job) return;
+
+  QMutexLocker lock(&m_mutex);
+  m_pending++;
+  i_job->m_finished = false;
+  queue(i_job);
+}
+
+// -------------------------------------------------------------------------
+// wait() : wait until every submitted job is done
+//
+// notes : the calling thread steals and runs jobs while it waits.
+//         a job must not call wait(), it would wait for itself
+// -------------------------------------------------------------------------
+
+void Scheduler::wait()
+{
+  int id = currentWorker();
+  for (;;) {
+    Job* job = take(id < 0 ? 0 : id);
+    if (job) {
+      execute(job, id < 0 ? workers() : id);
+      continue;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    if (m_pending == 0) return;
+    if (m_queued == 0)
+      m_done.wait(&m_mutex, IDLE_TIMEOUT);
+  }
+}
+
+// -------------------------------------------------------------------------
+// wait(job) : wait until a submitted job is done
+//
+// notes : the calling thread runs other jobs meanwhile, so a job can
+//         wait for the jobs it submitted
+// -------------------------------------------------------------------------
+
+void Scheduler::wait(Job* i_job)
+{
+  if (!i_job) return;
+
+  int id = currentWorker();
+  for (;;) {
+    {
+      QMutexLocker lock(&m_mutex);
+      if (i_job->m_finished) return;
+    }
+    Job* job = take(id < 0 ? 0 : id);
+    if (job) {
+      execute(job, id < 0 ? workers() : id);
+      continue;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    if (i_job->m_finished) return;
+    if (m_queued == 0)
+      m_done.wait(&m_mutex, IDLE_TIMEOUT);
+  }
+}
+
+// -------------------------------------------------------------------------
+// parallelFor(count, body, grain) : run a loop on all the threads
+//
+// grain : smallest chunk worth a job (a short loop is run right away)
+//
+// notes : the chunks must not depend on each other. the calling thread
+//         runs chunks too, until the last one is done
+// -------------------------------------------------------------------------
+
+void Scheduler::parallelFor(int i_count, Loop& i_body, int i_grain)
+{
+  if (i_count <= 0) return;
+  if (i_grain < 1) i_grain = 1;
+
+  int chunks = (workers() + 1) * CHUNKS_PER_THREAD;
+  int size   = (i_count + chunks - 1) / chunks;
+  if (size < i_grain) size = i_grain;
+  if (size >= i_count) {
+    i_body.run(0, i_count);
+    return;
+  }
+
+  std::vector<Chunk> parts;
+  parts.reserve((i_count + size - 1) / size);
+  for (int begin = 0; begin < i_count; begin += size)
+    parts.push_back(Chunk(&i_body, begin, std::min(begin + size, i_count)));
+
+  for (unsigned int i = 0; i < parts.size(); i++)
+    submit(&parts[i]);
+  for (unsigned int i = 0; i < parts.size(); i++)
+    wait(&parts[i]);
+}
+
+// -------------------------------------------------------------------------
+// busyTimes(seconds) : time spent running jobs since the last call
+// -------------------------------------------------------------------------
+
+void Scheduler::busyTimes(std::vector<double>& o_seconds)
+{
+  QMutexLocker lock(&m_mutex);
+  o_seconds.resize(m_busy.size());
+  for (unsigned int i = 0; i < m_busy.size(); i++) {
+    o_seconds[i] = m_busy[i] / 1e9;
+    m_busy[i] = 0;
+  }
+}
+
+// -------------------------------------------------------------------------
+// take(first) : take a job from the back of deque 'first', or steal one
+//               from the front of another deque
+//
+// return value : 0 if there is no job left
+// -------------------------------------------------------------------------
+
+Job* Scheduler::take(int i_first)
+{
+  int n = workers();
+  for (int i = 0; i < n; i++) {
+    Worker* w = m_workers[(i_first + i) % n];
+    Job* job = 0;
+    {
+      QMutexLocker lock(&w->m_mutex);
+      if (w->m_jobs.empty()) continue;
+      if (i == 0) {
+        job = w->m_jobs.back();  w->m_jobs.pop_back();
+      }
+      else {
+        job = w->m_jobs.front(); w->m_jobs.pop_front();
+      }
+    }
+    QMutexLocker lock(&m_mutex);
+    m_queued--;
+    return job;
+  }
+  return 0;
+}
+
+// -------------------------------------------------------------------------
+// queue(job) : put a job ready to run in a deque (m_mutex is locked)
+// -------------------------------------------------------------------------
+
+void Scheduler::queue(Job* i_job)
+{
+  int id = currentWorker();
+  if (id < 0) id = (m_next++) % workers();
+  m_queued++;
+  {
+    Worker* w = m_workers[id];
+    QMutexLocker lock(&w->m_mutex);
+    w->m_jobs.push_back(i_job);
+  }
+  m_work.wakeOne();
+}
+
+// -------------------------------------------------------------------------
+// execute(job, thread) : run a job
+//
+// thread : where the time is accounted (see busyTimes)
+// -------------------------------------------------------------------------
+
+void Scheduler::execute(Job* i_job, int i_thread)
+{
+  QElapsedTimer clock;
+  clock.start();
+  i_job->run();
+  qint64 busy = clock.nsecsElapsed();
+
+  QMutexLocker lock(&m_mutex);
+  m_busy[i_thread] += busy;
+  i_job->m_finished = true;
+  m_pending--;
+  m_done.wakeAll();
+}
+
+// -------------------------------------------------------------------------
+// currentWorker() : index of the calling worker thread (-1 if none)
+// -------------------------------------------------------------------------
+
+int Scheduler::currentWorker() const
+{
+  QThread* current = QThread::currentThread();
+  for (int i = 0; i < (int)m_workers.size(); i++)
+    if (m_workers[i] == current) return i;
+  return -1;
+}
@@ -0,0 +1,118 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+class   Scheduler;
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+#include <vector>
+
+class Job
+//
+// Job : unit of work run by the Scheduler
+//
+{
+ public:
+  Job();
+  virtual ~Job();
+  virtual void run() = 0;
+
+ private:
+  friend class Scheduler;
+  bool m_finished; // run (or never submitted)
+};
+
+class Loop
+//
+// Loop : body of a loop run in parallel (see Scheduler::parallelFor)
+//
+{
+ public:
+  virtual ~Loop();
+
+  // run the iterations [begin, end[
+  virtual void run(int i_begin, int i_end) = 0;
+};
+
+class Scheduler
+//
+// Scheduler : small work-stealing thread pool
+//
+//   - each worker thread owns a deque of jobs. it takes its own jobs
+//     from the back, and steals jobs from the front of the other deques
+//     when its own deque is empty
+//   - jobs submitted from a worker go to that worker's deque, other jobs
+//     are distributed round robin
+//   - jobs are not owned by the scheduler
+//
+{
+ public:
+  Scheduler(int i_workers = 0); // 0 -> one worker per processor
+  ~Scheduler();
+
+  int workers() const;
+
+  // add a job to be run by one of the workers
+  void submit(Job* i_job);
+
+  // wait until every submitted job is done (the caller helps meanwhile)
+  void wait();
+
+  // wait until one job is done (the caller helps, it may be a job)
+  void wait(Job* i_job);
+
+  // run the iterations [0, count[ of a loop, in chunks of at least
+  // 'grain' iterations, and wait until they are all done
+  void parallelFor(int i_count, Loop& i_body, int i_grain = 1);
+
+  // time spent running jobs since the last call (s), one entry for each
+  // worker, and a last one for the other threads (helping while waiting)
+  void busyTimes(std::vector<double>& o_seconds);
+
+ private:
+  class Worker;
+  friend class Worker;
+
+  // take a job, first from deque 'i_first', then from the others
+  Job* take(int i_first);
+  void queue(Job* i_job);
+  void execute(Job* i_job, int i_thread);
+  int  currentWorker() const;
+
+  typedef std::deque<Job*>     deq_jobs;
+  typedef std::vector<Worker*> vec_workers;
+  typedef std::vector<qint64>  vec_times;
+
+  vec_workers    m_workers;   // worker threads (each one owns a deque)
+  QMutex         m_mutex;     // protects the counters below
+  QWaitCondition m_work;      // signaled when a job is submitted
+  QWaitCondition m_done;      // signaled when a job is done
+  int            m_queued;    // jobs waiting in the deques
+  int            m_pending;   // jobs submitted but not done yet
+  int            m_next;      // next deque for round robin submission
+  bool           m_quit;      // workers should stop
+  vec_times      m_busy;      // time spent running jobs (ns), by thread
+};
+
+#endif // SCHEDULER_H
@@ -15,5 +15,5 @@ RC_FILE = shaolin_sheep.rc
 CONFIG += release
 
 # Input
-HEADERS += gldemowidget.h mainwidget.h ball.h texture.h cylinder.h globject.h quadric.h sphere.h disk.h tube.h scene.h transform.h camera.h vector.h matrix.h sheep.h material.h color.h boundingsphere.h physics.h
-SOURCES += main.cpp gldemowidget.cpp mainwidget.cpp ball.cpp texture.cpp cylinder.cpp globject.cpp quadric.cpp sphere.cpp disk.cpp tube.cpp scene.cpp transform.cpp camera.cpp vector.cpp matrix.cpp sheep.cpp material.cpp color.cpp boundingsphere.cpp physics.cpp
+HEADERS += gldemowidget.h mainwidget.h ball.h texture.h cylinder.h globject.h quadric.h sphere.h disk.h tube.h scene.h transform.h camera.h vector.h matrix.h sheep.h material.h color.h boundingsphere.h physics.h random.h scheduler.h batch.h snapshot.h sceneloader.h renderbench.h sheepanimator.h textureatlas.h terrain.h streambuffer.h spatialgrid.h ray.h boundinghierarchy.h flock.h contactsolver.h memorystats.h worldpager.h lightingshader.h materialregistry.h
+SOURCES += main.cpp gldemowidget.cpp mainwidget.cpp ball.cpp texture.cpp cylinder.cpp globject.cpp quadric.cpp sphere.cpp disk.cpp tube.cpp scene.cpp transform.cpp camera.cpp vector.cpp matrix.cpp sheep.cpp material.cpp color.cpp boundingsphere.cpp physics.cpp random.cpp scheduler.cpp batch.cpp snapshot.cpp sceneloader.cpp renderbench.cpp sheepanimator.cpp textureatlas.cpp terrain.cpp streambuffer.cpp spatialgrid.cpp ray.cpp boundinghierarchy.cpp flock.cpp contactsolver.cpp memorystats.cpp worldpager.cpp lightingshader.cpp materialregistry.cpp
@@ -20,22 +20,32 @@
 */
 
 #include "sheep.h"
+#include "boundingsphere.h"
 #include "texture.h"
 #include "sphere.h"
 #include "cylinder.h"
 #include "material.h"
+#include "materialregistry.h"
 #include "color.h"
 #include "transform.h"
 #include "vector.h"
+#include "random.h"
+#include "sheepanimator.h"
+#include "lightingshader.h"
+#include <QtOpenGL>
+#include <QGLShaderProgram>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPainter>
 #include <QPainterPath>
-#include <cstdlib>
 #include <cmath>
+#include <vector>
 
 // Wool texture generation
 #define WOOL_TEX_SIZE           256    // texture size      = x * x
 #define WOOL_CUBIC_SIZE         10     // bezier curve size = x * x
 #define WOOL_ITERATIONS         2000   // number of bezier curves
+#define WOOL_SEED               42     // wool pattern random seed
 
 // Leg movement
 #define WALK_LEG_MAX            25.    // (walking) maximum foward   rotation
@@ -53,14 +63,310 @@
 
 #define MAX_STEPS_PER_SECOND    MAX_STEPS_PER_MINUTE / 60.
 
+// Collision shape (model units : the body is 1 long)
+#define BODY_PART_OFFSET        0.15   // two spheres along the body
+#define BODY_PART_RADIUS        0.35
+#define HEAD_PART_RADIUS        0.25
+
+// the shader is given the same animation constants
+#define GLSL_STRING(x)          #x
+#define GLSL_DEFINE(x)          "#define " #x " " GLSL_STRING(x) "\n"
+
 Texture* Sheep::sp_wool = 0;    // dynamically generated wool texture
 int Sheep::s_wool_count = 0;    // how many sheep share this texture?
+bool Sheep::s_shader_animation = false; // animated in a vertex shader?
+
+// sheep may be created and destroyed by scenes living in other threads
+static QMutex s_wool_mutex;
+
+// -------------------------------------------------------------------------
+// SheepShader : vertex shader animating the sheep model
+//
+// notes : each part of the model is drawn with its rest transform (see
+//         PartPose), the shader then does what setAnimationPhase and
+//         globject_tick do on the cpu : breathing, leg swing, rocking,
+//         size and orientation. lighting is computed the way the fixed
+//         pipeline does it (light 0), fragments are left to the fixed
+//         pipeline (wool texture).
+// -------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------
+// PartPose : rest transforms of a part (leaf) of the sheep model
+//
+// notes : a part moves around its pivot (ex: a leg swings around the top
+//         of the leg), the pivot transform is relative to the sheep model
+//         and the local transform is relative to the pivot. all the sheep
+//         share the same model, so the same poses.
+// -------------------------------------------------------------------------
+
+struct PartPose
+{
+  enum Kind { RIGID = 0, BODY = 1, LEG = 2 };
+
+  GLfloat local[4][4];       // part to pivot
+  GLfloat localNormal[4][4]; // same, for normals (inversed scalings)
+  GLfloat pivot[4][4];       // pivot to sheep model
+  GLfloat pivotNormal[4][4]; // same, for normals (inversed scalings)
+  Kind    kind;              // what animates the part
+  bool    front, right;      // which leg
+};
+
+typedef std::vector<PartPose> vec_poses;
+static vec_poses s_part_poses;
+
+static const char* SHEEP_VERTEX_SHADER =
+  GLSL_DEFINE(WALK_LEG_MAX)
+  GLSL_DEFINE(WALK_LEG_MIN)
+  GLSL_DEFINE(RUN_LEG_MAX)
+  GLSL_DEFINE(RUN_LEG_MIN)
+  GLSL_DEFINE(WALK_OFFSET)
+  GLSL_DEFINE(RUN_OFFSET)
+  "#define TWO_PI 6.28318531\n"
+  "\n"
+  "uniform float phase;       // animation cycle phase [0, 2[\n"
+  "uniform float walking;     // 1 : walking, 0 : running\n"
+  "uniform float waiting;     // 1 : standing still\n"
+  "uniform float orientation; // degrees around the y-axis\n"
+  "uniform float size;        // sheep body length\n"
+  "uniform mat4  local;       // part rest transform, to its pivot\n"
+  "uniform mat4  localNormal;\n"
+  "uniform mat4  pivot;       // pivot rest transform (model space)\n"
+  "uniform mat4  pivotNormal;\n"
+  "uniform int   kind;        // 0 : rigid, 1 : body, 2 : leg\n"
+  "uniform vec2  leg;         // (front, right) : 1 or 0\n"
+  "\n"
+  "vec2 rotate(vec2 v, float degrees)\n"
+  "{\n"
+  "  float c = cos(radians(degrees)); float s = sin(radians(degrees));\n"
+  "  return vec2(v.x * c - v.y * s, v.x * s + v.y * c);\n"
+  "}\n"
+  "\n"
+  "void main()\n"
+  "{\n"
+  "  vec4 v = gl_Vertex;\n"
+  "  vec3 n = gl_Normal;\n"
+  "\n"
+  "  if (kind == 1) {\n"
+  "    // two breathes per cycle\n"
+  "    float s = cos((phase / 2.) * TWO_PI) * 0.02;\n"
+  "    v.yz *= vec2(1. + s, 1. - s);\n"
+  "    n.yz /= vec2(1. + s, 1. - s);\n"
+  "  }\n"
+  "  v = local * v;\n"
+  "  n = (localNormal * vec4(n, 0.)).xyz;\n"
+  "\n"
+  "  if ((kind == 2) && (waiting < 0.5)) {\n"
+  "    // leg position [-1, 1], then rotation around the leg y-axis\n"
+  "    float angle;\n"
+  "    if (walking > 0.5) {\n"
+  "      float a = sin((phase + (leg.x == leg.y ? 0. : WALK_OFFSET)) *\n"
+  "                    TWO_PI);\n"
+  "      angle = (WALK_LEG_MAX + WALK_LEG_MIN) / 2. +\n"
+  "              (WALK_LEG_MAX - WALK_LEG_MIN) / 2. * a;\n"
+  "    }\n"
+  "    else {\n"
+  "      float a = sin((phase + (leg.x > 0.5 ? 0. : RUN_OFFSET)) *\n"
+  "                    TWO_PI) * 1.5 - 0.5;\n"
+  "      angle = (RUN_LEG_MAX + RUN_LEG_MIN) / 2. * (leg.x * 2. - 1.) +\n"
+  "              (RUN_LEG_MAX - RUN_LEG_MIN) / 2. * max(a, -1.);\n"
+  "    }\n"
+  "    v.zx = rotate(v.zx, angle);\n"
+  "    n.zx = rotate(n.zx, angle);\n"
+  "  }\n"
+  "\n"
+  "  // pivot transform, then rocking (x-axis), size and orientation\n"
+  "  v = pivot * v;\n"
+  "  n = (pivotNormal * vec4(n, 0.)).xyz;\n"
+  "  float rock = sin(phase * TWO_PI) * 2.;\n"
+  "  v.yz = rotate(v.yz, rock);\n"
+  "  n.yz = rotate(n.yz, rock);\n"
+  "  v.xyz *= size;\n"
+  "  v.zx = rotate(v.zx, orientation);\n"
+  "  n.zx = rotate(n.zx, orientation);\n"
+  "\n"
+  "  gl_Position = gl_ModelViewProjectionMatrix * v;\n"
+  "  gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+  "\n"
+  "  // light 0, as the fixed pipeline would do it\n"
+  "  vec4 ec = gl_ModelViewMatrix * v;\n"
+  "  vec3 nn = normalize(gl_NormalMatrix * n);\n"
+  "  vec4 lp = gl_LightSource[0].position;\n"
+  "  vec3 l  = normalize(lp.w == 0. ? lp.xyz : lp.xyz - ec.xyz);\n"
+  "  float d = max(dot(nn, l), 0.);\n"
+  "  vec4 c  = gl_FrontLightModelProduct.sceneColor +\n"
+  "            gl_FrontLightProduct[0].ambient +\n"
+  "            gl_FrontLightProduct[0].diffuse * d;\n"
+  "  if (d > 0.) {\n"
+  "    float h = max(dot(nn, normalize(l + vec3(0., 0., 1.))), 0.);\n"
+  "    float shininess = gl_FrontMaterial.shininess;\n"
+  "    c += gl_FrontLightProduct[0].specular *\n"
+  "         (shininess > 0. ? pow(h, shininess) : 1.);\n"
+  "  }\n"
+  "  c.a = gl_FrontMaterial.diffuse.a;\n"
+  "  gl_FrontColor = clamp(c, 0., 1.);\n"
+  "}\n";
+
+class SheepShader
+{
+ public:
+  SheepShader()
+    :mp_program(0), m_phase(-1), m_walking(-1), m_waiting(-1),
+     m_orientation(-1), m_size(-1), m_local(-1), m_local_normal(-1),
+     m_pivot(-1), m_pivot_normal(-1), m_kind(-1), m_leg(-1) {}
+  ~SheepShader() { delete mp_program; mp_program = 0; }
+
+  // compile the shader in the current opengl context
+  bool create()
+  {
+    if (!QGLShaderProgram::hasOpenGLShaderPrograms()) return false;
+
+    mp_program = new QGLShaderProgram;
+    if (!mp_program->addShaderFromSourceCode(QGLShader::Vertex,
+                                             SHEEP_VERTEX_SHADER) ||
+        !mp_program->link()) {
+      qWarning("sheep shader : %s",
+               mp_program->log().toLocal8Bit().constData());
+      delete mp_program; mp_program = 0;
+      return false;
+    }
+
+    m_phase       = mp_program->uniformLocation("phase");
+    m_walking     = mp_program->uniformLocation("walking");
+    m_waiting     = mp_program->uniformLocation("waiting");
+    m_orientation = mp_program->uniformLocation("orientation");
+    m_size        = mp_program->uniformLocation("size");
+    m_local        = mp_program->uniformLocation("local");
+    m_local_normal = mp_program->uniformLocation("localNormal");
+    m_pivot        = mp_program->uniformLocation("pivot");
+    m_pivot_normal = mp_program->uniformLocation("pivotNormal");
+    m_kind        = mp_program->uniformLocation("kind");
+    m_leg         = mp_program->uniformLocation("leg");
+    return true;
+  }
+
+  void bind()    { mp_program->bind(); }
+  void release() { mp_program->release(); }
+
+  // per-instance animation state
+  void setInstance(double i_phase, bool i_walking, bool i_waiting,
+                   double i_orientation, double i_size)
+  {
+    // the phase keeps growing, only one breathing cycle is uploaded
+    mp_program->setUniformValue(m_phase,
+                                (GLfloat)(i_phase - 2. * floor(i_phase / 2.)));
+    mp_program->setUniformValue(m_walking, (GLfloat)(i_walking ? 1. : 0.));
+    mp_program->setUniformValue(m_waiting, (GLfloat)(i_waiting ? 1. : 0.));
+    mp_program->setUniformValue(m_orientation, (GLfloat)i_orientation);
+    mp_program->setUniformValue(m_size, (GLfloat)i_size);
+  }
+
+  // per-part rest transforms and kind of animation
+  void setPart(const PartPose& i_pose)
+  {
+    mp_program->setUniformValue(m_local, i_pose.local);
+    mp_program->setUniformValue(m_local_normal, i_pose.localNormal);
+    mp_program->setUniformValue(m_pivot, i_pose.pivot);
+    mp_program->setUniformValue(m_pivot_normal, i_pose.pivotNormal);
+    mp_program->setUniformValue(m_kind, (GLint)i_pose.kind);
+    mp_program->setUniformValue(m_leg, (GLfloat)(i_pose.front ? 1. : 0.),
+                                       (GLfloat)(i_pose.right ? 1. : 0.));
+  }
+
+ private:
+  QGLShaderProgram* mp_program;
+  int m_phase, m_walking, m_waiting, m_orientation, m_size;
+  int m_local, m_local_normal, m_pivot, m_pivot_normal, m_kind, m_leg;
+};
+
+static SheepShader* sp_shader = 0;
+
+// -------------------------------------------------------------------------
+// PoseBuilder : read the rest transforms of the parts under a node
+//
+// notes : opengl does the matrix products. for normals, the rotations are
+//         kept and the scalings are inversed.
+// -------------------------------------------------------------------------
+
+struct PoseBuilder
+{
+  const Globject* body;       // the body breathes
+  const Globject* legs[2][2]; // legs swing
+  bool            normal;     // normal transforms?
+  int             part;       // next part
+
+  void build(Globject* i_node, PartPose::Kind i_kind, bool i_front,
+             bool i_right, const GLfloat* i_pivot)
+  {
+    glPushMatrix();
+    Transform& t = i_node->transform();
+    if (normal) {
+      const Vector& s = t.scaling();
+      glMultMatrixd(t.rotation().array());
+      glScaled(1. / s.x(), 1. / s.y(), 1. / s.z());
+    }
+    else t.apply();
+
+    // a leg is the pivot of its parts
+    GLfloat pivot[4][4];
+    for (int i = 0; i < 2; i++)
+      for (int j = 0; j < 2; j++)
+        if (i_node == legs[i][j]) {
+          i_kind = PartPose::LEG; i_front = (i == 0); i_right = (j == 0);
+          glGetFloatv(GL_MODELVIEW_MATRIX, &pivot[0][0]);
+          glLoadIdentity();
+          i_pivot = &pivot[0][0];
+        }
+    if (i_node == body) i_kind = PartPose::BODY;
+
+    const Globject::vec_globject& children = i_node->children();
+    if (children.empty()) {
+      if (!normal) s_part_poses.push_back(PartPose());
+      PartPose& pose = s_part_poses[part++];
+      GLfloat* p_local = normal ? &pose.localNormal[0][0] : &pose.local[0][0];
+      GLfloat* p_pivot = normal ? &pose.pivotNormal[0][0] : &pose.pivot[0][0];
+      glGetFloatv(GL_MODELVIEW_MATRIX, p_local);
+      for (int k = 0; k < 16; k++)
+        p_pivot[k] = i_pivot ? i_pivot[k] : ((k % 5) == 0 ? 1.f : 0.f);
+      pose.kind  = i_kind;
+      pose.front = i_front;
+      pose.right = i_right;
+    }
+    for (Globject::vec_globject::const_iterator i = children.begin();
+         i != children.end(); i++)
+      build(*i, i_kind, i_front, i_right, i_pivot);
+
+    glPopMatrix();
+  }
+};
+
+// -------------------------------------------------------------------------
+// drawParts(node, gl, part) : draw the parts (leaves) under 'node', in
+//                             the order of s_part_poses
+// -------------------------------------------------------------------------
+
+static void drawParts(Globject* i_node, QGLWidget* i_gl, int& io_part)
+{
+  const Globject::vec_globject& children = i_node->children();
+  for (Globject::vec_globject::const_iterator i = children.begin();
+       i != children.end(); i++)
+    drawParts(*i, i_gl, io_part);
+
+  if (children.empty()) {
+    sp_shader->setPart(s_part_poses[io_part++]);
+
+    // every leaf of the sheep model is a quadric
+    ((Quadric*)i_node)->drawShape(i_gl);
+  }
+}
+
 
 // -------------------------------------------------------------------------
 // Sheep(size) : create a new animated sheep model
 //               (body length 'size' meters)
 //
-// notes : wool texture is dynamically generated using Qt painter tools
+// notes : wool texture is dynamically generated using Qt painter tools,
+//         using its own random generator so the pattern never depends on
+//         the scene being simulated
 // -------------------------------------------------------------------------
 
 Sheep::Sheep(double i_size)
@@ -69,9 +375,14 @@ Sheep::Sheep(double i_size)
    m_waiting(false),
    m_phase(NAN),
    m_orientation(0.),
+   m_rate(1),
+   m_late_ticks(0),
+   m_late_sec(0.),
+   m_late_cycles(0.),
    m_size(i_size),
    mp_sheep (0), mp_body (0), mp_head(0),
-   mp_head_a(0), mp_mouth(0), mp_tail(0)
+   mp_head_a(0), mp_mouth(0), mp_tail(0),
+   mp_animator(0), m_queued(false)
 {
   // object initialisation
   for (int i=0; i<2; i++) {
@@ -80,34 +391,19 @@ Sheep::Sheep(double i_size)
     mp_leg[i][0] = 0; mp_leg[i][1] = 0;
   }
 
-  // wool texture generation (using bezier curves)
-  if (s_wool_count++ == 0) {
-    sp_wool = new Texture(WOOL_TEX_SIZE);
-
-    QPainter p(&(sp_wool->pixmap()));
-    p.fillRect(0, 0, WOOL_TEX_SIZE, WOOL_TEX_SIZE, Qt::white);
-    p.setPen(Qt::gray);
-
-    for (int i = 0; i < WOOL_ITERATIONS; i++) {
-      QPainterPath pp; int x; int y;
-      int s = rand() % WOOL_CUBIC_SIZE + 1;
-      pp.moveTo(x = rand() % (WOOL_TEX_SIZE - WOOL_CUBIC_SIZE),
-                y = rand() % (WOOL_TEX_SIZE - WOOL_CUBIC_SIZE));
-      pp.cubicTo(x,y+s, x+s,y+s, x+s,y);
-      p.drawPath(pp);
-      p.rotate(90);
-    }
-  }
+  // wool texture, shared by all the sheep
+  retainWool();
 
   // sheep model crude definition
   Globject* sheep = new Globject;
   {
-    // colors used in the model
-    Material white   (Color(1.0, 1.0, 1.0));
-    Material gray    (Color(0.7, 0.7, 0.7));
-    Material brown   (Color(207, 173, 117));
-    Material dk_brown(Color(207, 173, 117) * 0.9);
-    Material black   (Color(0.0, 0.0, 0.0));
+    // colors used in the model, registered by the first sheep
+    static const MaterialRegistry::Id
+      white    = MaterialRegistry::intern(Color(1.0, 1.0, 1.0)),
+      gray     = MaterialRegistry::intern(Color(0.7, 0.7, 0.7)),
+      brown    = MaterialRegistry::intern(Color(207, 173, 117)),
+      dk_brown = MaterialRegistry::intern(Color(207, 173, 117) * 0.9),
+      black    = MaterialRegistry::intern(Color(0.0, 0.0, 0.0));
 
     // sheep's body
     Sphere* body = new Sphere(0.5);
@@ -207,6 +503,9 @@ Sheep::Sheep(double i_size)
   mp_sheep = sheep;
   this->addChild(mp_sheep);
 
+  // with shader animation, the model is drawn by globject_draw
+  mp_sheep->setVisible(!s_shader_animation);
+
   // set the model to its starting configuration
   setAnimationPhase(0.);
   setWaitingPosition();
@@ -214,12 +513,12 @@ Sheep::Sheep(double i_size)
 
 Sheep::~Sheep()
 {
+  // the animator must not pose a deleted sheep
+  if (mp_animator) mp_animator->unqueue(this);
+
   // wool texture
   if (mp_body) mp_body->setTexture(0);
-  if (s_wool_count == 1) {
-    delete sp_wool; sp_wool = 0;
-    s_wool_count--;
-  }
+  releaseWool();
 
   // sheep model : there is no need to free model parts since they are
   //               all children of this object.
@@ -248,10 +547,161 @@ void Sheep::setVelocity(const Vector& i_velocity)
   setDisplacementMode((vel / getStride(true)) <= MAX_STEPS_PER_SECOND);
 }
 
+// -------------------------------------------------------------------------
+// animation state : to save and restore a sheep
+//
+// notes : setAnimationState() should be called after setVelocity(), since
+//         the velocity decides if the sheep walks or runs
+// -------------------------------------------------------------------------
+
+double Sheep::size() const
+{
+  return m_size;
+}
+
+double Sheep::phase() const
+{
+  return m_phase;
+}
+
+double Sheep::orientation() const
+{
+  return m_orientation;
+}
+
+bool Sheep::walking() const
+{
+  return m_walking;
+}
+
+bool Sheep::waiting() const
+{
+  return m_waiting;
+}
+
+void Sheep::setAnimationState(double i_phase, double i_orientation,
+                              bool i_walking, bool i_waiting)
+{
+  m_orientation = i_orientation;
+  m_late_ticks  = 0;
+  m_late_sec    = 0.;
+  m_late_cycles = 0.;
+  setDisplacementMode(i_walking);
+
+  // force the body parts to be updated
+  m_phase = NAN;
+  setAnimationPhase(i_phase);
+
+  if (i_waiting) {
+    m_waiting = false;
+    setWaitingPosition();
+  }
+}
+
+// -------------------------------------------------------------------------
+// retainWool()  : one more user of the wool texture, the first one
+//                 generates it (using bezier curves)
+// releaseWool() : one user less, the last one deletes it
+// -------------------------------------------------------------------------
+
+void Sheep::retainWool()
+{
+  QMutexLocker lock(&s_wool_mutex);
+  if (s_wool_count++ > 0) return;
+
+  sp_wool = new Texture(WOOL_TEX_SIZE);
+
+  Random rnd(WOOL_SEED);
+  QPainter p(&(sp_wool->pixmap()));
+  p.fillRect(0, 0, WOOL_TEX_SIZE, WOOL_TEX_SIZE, Qt::white);
+  p.setPen(Qt::gray);
+
+  for (int i = 0; i < WOOL_ITERATIONS; i++) {
+    QPainterPath pp; int x; int y;
+    int s = rnd.nextInt(WOOL_CUBIC_SIZE) + 1;
+    pp.moveTo(x = rnd.nextInt(WOOL_TEX_SIZE - WOOL_CUBIC_SIZE),
+              y = rnd.nextInt(WOOL_TEX_SIZE - WOOL_CUBIC_SIZE));
+    pp.cubicTo(x,y+s, x+s,y+s, x+s,y);
+    p.drawPath(pp);
+    p.rotate(90);
+  }
+}
+
+void Sheep::releaseWool()
+{
+  QMutexLocker lock(&s_wool_mutex);
+  if (--s_wool_count > 0) return;
+
+  delete sp_wool; sp_wool = 0;
+  delete sp_shader; sp_shader = 0;
+}
+
+// -------------------------------------------------------------------------
+// setShaderAnimation(shader) : animate the sheep in a vertex shader
+//
+// notes : the body parts then keep their rest transforms, only the
+//         animation state (phase, walking / running, orientation) changes
+//         on the cpu. if the opengl context can't run the shader, sheep
+//         go back to the cpu animation when they are first drawn.
+// -------------------------------------------------------------------------
+
+void Sheep::setShaderAnimation(bool i_shader)
+{
+  s_shader_animation = i_shader;
+}
+
+bool Sheep::shaderAnimation()
+{
+  return s_shader_animation;
+}
+
+// -------------------------------------------------------------------------
+// setAnimator(animator) : let an animator pose the sheep
+//
+// notes : the body parts are then only updated by SheepAnimator::update(),
+//         starting with the current pose : its curves are evaluated in
+//         floats, and must not depend on where the sheep came from (a
+//         new sheep, or one restored from a snapshot). a pose still
+//         waiting in the previous animator is not lost.
+// -------------------------------------------------------------------------
+
+void Sheep::setAnimator(SheepAnimator* i_animator)
+{
+  bool queued = m_queued;
+  if (mp_animator) mp_animator->unqueue(this);
+  mp_animator = i_animator;
+
+  if (mp_animator) {
+    if (!s_shader_animation) mp_animator->queue(this);
+  }
+  else if (queued)
+    setAnimationState(m_phase, m_orientation, m_walking, m_waiting);
+}
+
+// -------------------------------------------------------------------------
+// setAnimationRate(ticks) : animation level of detail
+//
+// notes : far away sheep don't need their legs to move 60 times a second,
+//         and hidden ones don't need them to move at all (see Scene::cull)
+// -------------------------------------------------------------------------
+
+void Sheep::setAnimationRate(int i_ticks)
+{
+  m_rate = (i_ticks > 0) ? i_ticks : 0;
+}
+
+int Sheep::animationRate() const
+{
+  return m_rate;
+}
+
 // -------------------------------------------------------------------------
 // globject_tick(seconds) : animation tick
 //
-// notes        : will set the sheep orientation and call walkOrRun
+// notes        : will set the sheep orientation and animation phase.
+//                with a lower animation rate, the time and leg cycles
+//                since the last update are accumulated, so the phase is
+//                carried forward (the movement itself is never late)
 // return value : 'true' when the sheep has moved
 // -------------------------------------------------------------------------
 
@@ -263,14 +713,25 @@ bool Sheep::globject_tick(double i_sec)
   Vector vec = velocity(); vec.setY(0.);
   double vel = vec.l2norm();
 
-  if (vec.l2normalize() && (vel >= MIN_VELOCITY)) {
-    // if the sheep is running, there is a limit to how fast the legs
-    // will move. legs moving too fast would seem unrealistic.
-    if (!m_walking) {
-      double max_vel = MAX_STEPS_PER_SECOND * getStride(false);
-      if (vel > max_vel) vel = max_vel;
-    }
+  // if the sheep is running, there is a limit to how fast the legs
+  // will move. legs moving too fast would seem unrealistic.
+  double legs = vel;
+  if (!m_walking) {
+    double max_vel = MAX_STEPS_PER_SECOND * getStride(false);
+    if (legs > max_vel) legs = max_vel;
+  }
+
+  // the animation may be updated only once every few ticks, the leg
+  // cycles are counted meanwhile
+  m_late_sec    += i_sec;
+  m_late_cycles += (legs * i_sec) / getStride(m_walking);
+  if ((m_rate == 0) || (++m_late_ticks < m_rate)) return res;
+
+  double sec    = m_late_sec;
+  double cycles = m_late_cycles;
+  m_late_ticks = 0; m_late_sec = 0.; m_late_cycles = 0.;
 
+  if (vec.l2normalize() && (vel >= MIN_VELOCITY)) {
     // calculate what should be the sheep orientation
     // (degrees to rotate the sheep around the y-axis, 0 --> i)
     double new_orientation = (180. * acos(vec.x())) / M_PI;
@@ -283,13 +744,13 @@ bool Sheep::globject_tick(double i_sec)
 
     // see if it is possible to make all that rotation on time
     {
-      double max_rotation = (i_sec * MAX_DEGREES_PER_SECOND);
+      double max_rotation = (sec * MAX_DEGREES_PER_SECOND);
       double difference = fabs(rotation) - max_rotation;
       if (difference > 0.) {
         rotation = (rotation > 0.) ? max_rotation : -max_rotation;
 
         // if the sheep can't turn fast enough, it will walk backwards
-        if (difference > 90.) vel = -vel;
+        if (difference > 90.) cycles = -cycles;
       }
     }
 
@@ -298,10 +759,11 @@ bool Sheep::globject_tick(double i_sec)
     if (m_orientation   >   180.) m_orientation -= 360.; else
       if (m_orientation <= -180.) m_orientation += 360.;
 
-    transform().setRotation(m_orientation, Vector::j);
+    if (!s_shader_animation)
+      transform().setRotation(m_orientation, Vector::j);
 
     // now that the orientation is set, lets make the sheep walk / run
-    walkOrRun(vel * i_sec);
+    if (cycles != 0.) setAnimationPhase(m_phase + cycles);
     res = true;
   }
   else if (!m_waiting) {
@@ -314,13 +776,33 @@ bool Sheep::globject_tick(double i_sec)
 }
 
 // -------------------------------------------------------------------------
-// walkOrRun(distance) : will animate legs to walk or run given distance (m)
+// globject_colliders(spheres) : the body (two spheres) and the head
+//
+// notes : the legs and tail are left to the outer bounding sphere (the
+//         sheep stands on it). with shader animation, the model isn't
+//         turned by the transform, it is turned here.
 // -------------------------------------------------------------------------
 
-void Sheep::walkOrRun(double i_distance)
+void Sheep::globject_colliders(vec_spheres& o_spheres) const
 {
-  if (i_distance != 0.)
-    setAnimationPhase(m_phase + (i_distance / getStride(m_walking)));
+  static const double PARTS[3][4] = {   // x, y, z, radius
+    {  BODY_PART_OFFSET, 0.,    0., BODY_PART_RADIUS },
+    { -BODY_PART_OFFSET, 0.,    0., BODY_PART_RADIUS },
+    {  0.5,              0.125, 0., HEAD_PART_RADIUS } };
+
+  double c = 1., s = 0.;
+  if (s_shader_animation) {
+    c = cos((m_orientation * M_PI) / 180.);
+    s = sin((m_orientation * M_PI) / 180.);
+  }
+
+  for (int i = 0; i < 3; i++) {
+    double x = PARTS[i][0] * m_size;
+    double y = PARTS[i][1] * m_size;
+    double z = PARTS[i][2] * m_size;
+    o_spheres.push_back(BoundingSphere(PARTS[i][3] * m_size,
+                                       Vector(x*c + z*s, y, z*c - x*s)));
+  }
 }
 
 // -------------------------------------------------------------------------
@@ -336,6 +818,19 @@ void Sheep::setAnimationPhase(double i_phase)
   if (m_phase != i_phase) {
     m_phase = i_phase;
 
+    // with shader animation, the body parts keep their rest transforms
+    if (s_shader_animation) {
+      m_waiting = false;
+      return;
+    }
+
+    // with an animator, the body parts are posed later, with other sheep
+    if (mp_animator) {
+      m_waiting = false;
+      mp_animator->queue(this);
+      return;
+    }
+
     // first, the body will be scaled to simulate subtle breathing
     {
       // two breathes per cycle
@@ -386,9 +881,10 @@ void Sheep::setAnimationPhase(double i_phase)
 void Sheep::setWaitingPosition()
 {
   if (!m_waiting) {
-    for (int i = 0; i < 2; i++)
-      for (int j = 0; j < 2; j++)
-        mp_leg[i][j]->transform().setRotation(90., Vector::i);
+    if (!s_shader_animation)
+      for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+          mp_leg[i][j]->transform().setRotation(90., Vector::i);
 
     m_waiting = true;
   }
@@ -443,3 +939,78 @@ double Sheep::getStride(bool i_walking)
     (RUN_LEG_MAX  - RUN_LEG_MIN ) / 360. * 3. * (2. * M_PI * legLength) ;
   return stride;
 }
+
+// -------------------------------------------------------------------------
+// globject_draw(gl) : draw the model animated by the vertex shader
+//
+// notes : with cpu animation, the model is drawn as any other child
+// -------------------------------------------------------------------------
+
+void Sheep::globject_draw(QGLWidget* i_gl)
+{
+  if (mp_sheep->visible()) return;
+
+  if (!s_shader_animation || !drawWithShader(i_gl)) {
+    // no shader support : back to the cpu animation
+    s_shader_animation = false;
+    mp_sheep->setVisible(true);
+    transform().setRotation(m_orientation, Vector::j);
+    setAnimationState(m_phase, m_orientation, m_walking, m_waiting);
+
+    // the sheep transform has already been applied without orientation
+    glPushMatrix();
+    glRotated(m_orientation, 0., 1., 0.);
+    mp_sheep->draw(i_gl);
+    glPopMatrix();
+  }
+}
+
+// -------------------------------------------------------------------------
+// drawWithShader(gl) : upload the animation state and draw the parts
+//
+// return value : 'false' if the shader can't be used
+// -------------------------------------------------------------------------
+
+bool Sheep::drawWithShader(QGLWidget* i_gl)
+{
+  if (!sp_shader) {
+    sp_shader = new SheepShader;
+    if (!sp_shader->create()) {
+      delete sp_shader; sp_shader = 0;
+      return false;
+    }
+  }
+
+  // the rest transforms are read from the first sheep drawn
+  if (s_part_poses.empty()) {
+    PoseBuilder builder;
+    builder.body = mp_body;
+    for (int i = 0; i < 2; i++)
+      for (int j = 0; j < 2; j++)
+        builder.legs[i][j] = mp_leg[i][j];
+
+    glMatrixMode(GL_MODELVIEW);
+    for (int normal = 0; normal < 2; normal++) {
+      builder.normal = (normal != 0);
+      builder.part   = 0;
+      glPushMatrix();
+      glLoadIdentity();
+      const vec_globject& children = mp_sheep->children();
+      for (vec_globject::const_iterator i = children.begin();
+           i != children.end(); i++)
+        builder.build(*i, PartPose::RIGID, false, false, 0);
+      glPopMatrix();
+    }
+  }
+
+  // the sheep shader lights on its own, from the opengl materials
+  bool shaded = LightingShader::end();
+  sp_shader->bind();
+  sp_shader->setInstance(m_phase, m_walking, m_waiting, m_orientation,
+                         m_size);
+  int part = 0;
+  drawParts(mp_sheep, i_gl, part);
+  sp_shader->release();
+  if (shaded) LightingShader::begin();
+  return true;
+}
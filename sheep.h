@@ -26,6 +26,7 @@ class   Sheep;
 class Texture;
 class Quadric;
 class Cylinder;
+class SheepAnimator;
 #include "globject.h"
 
 class Sheep : public Globject
@@ -40,24 +41,63 @@ class Sheep : public Globject
 
   virtual void setVelocity(const Vector& i_velocity);
 
+  // animation state (to save and restore a sheep)
+  double size() const;
+  double phase() const;
+  double orientation() const;
+  bool   walking() const;
+  bool   waiting() const;
+  void   setAnimationState(double i_phase, double i_orientation,
+                           bool i_walking, bool i_waiting);
+
+  // animate the sheep in a vertex shader instead of on the cpu
+  // (to be chosen before any sheep is created)
+  static void setShaderAnimation(bool i_shader);
+  static bool shaderAnimation();
+
+  // keep the wool texture alive, even without any sheep : its pixmap is
+  // then created and deleted by the calling (gui) thread, not by the
+  // thread that adds the first sheep or deletes the last one
+  static void retainWool();
+  static void releaseWool();
+
+  // let an animator pose the sheep along with many others (see
+  // SheepAnimator), 0 : the sheep poses itself at each phase change
+  void setAnimator(SheepAnimator* i_animator);
+
+  // animation level of detail : the orientation and leg cycle are only
+  // updated every 'ticks' ticks (1 : each tick, 0 : frozen). the sheep
+  // still moves at each tick, its animation catches up at the next update
+  void setAnimationRate(int i_ticks);
+  int  animationRate() const;
+
  protected:
   // walking / running animation methods
 
   virtual bool globject_tick(double i_sec);
+  virtual void globject_draw(QGLWidget* i_gl);
+  virtual void globject_colliders(vec_spheres& o_spheres) const;
 
-  void   walkOrRun(double i_distance);
   void   setAnimationPhase(double i_phase);
   void   setWaitingPosition();
   void   setLegPosition(bool i_front, bool i_right, double i_position);
   void   setDisplacementMode(bool i_walking);
   double getStride(bool i_walking);
 
+  // shader animation (see SheepShader)
+  bool   drawWithShader(QGLWidget* i_gl);
+
  private:
   bool      m_walking;     // true : walking, false : running
   bool      m_waiting;     // true : waiting, false : see m_walking
   double    m_phase;       // phase of the animation cycle [0., 1.[
   double    m_orientation; // current orientation, in degrees, 0 --> i
 
+  int       m_rate;        // animation updated every m_rate ticks
+  int       m_late_ticks;  // ticks since the last animation update
+  double    m_late_sec;    // time since the last animation update (s)
+  double    m_late_cycles; // leg cycles walked since then
+
   double    m_size;        // sheep body size (length), in meters
   Globject* mp_sheep;      // sheep model + body parts
   Quadric*  mp_body;
@@ -71,9 +111,16 @@ class Sheep : public Globject
   Globject* mp_tail;
   Cylinder* mp_leg[2][2];
 
+  SheepAnimator* mp_animator; // batched animation, if any
+  bool      m_queued;      // waiting for the animator to be posed?
+  friend class SheepAnimator;
+
  public:
   static Texture* sp_wool; // dynamically generated wool texture
   static int s_wool_count; // how many sheep share this texture?
+
+ private:
+  static bool s_shader_animation; // animated in a vertex shader?
 };
 
 #endif // SHEEP_H
@@ -0,0 +1,303 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "sheepanimator.h"
+#include "sheep.h"
+#include "quadric.h"
+#include "cylinder.h"
+#include "transform.h"
+#include "matrix.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+// must match the walking / running curves of Sheep::setAnimationPhase
+#define WALK_LEG_MAX            25.    // (walking) maximum foward   rotation
+#define WALK_LEG_MIN           -40.    // (walking) maximum backward rotation
+#define RUN_LEG_MAX             80.    // (running) maximum forward  rotation
+#define RUN_LEG_MIN            -60.    // (running) maximum backward rotation
+#define WALK_OFFSET             0.5    // offset between front legs
+#define RUN_OFFSET              0.15   // offset between front and back legs
+
+#define WALK_CENTER ((float)((WALK_LEG_MAX + WALK_LEG_MIN) / 2.))
+#define WALK_RANGE  ((float)((WALK_LEG_MAX - WALK_LEG_MIN) / 2.))
+#define RUN_CENTER  ((float)((RUN_LEG_MAX  + RUN_LEG_MIN ) / 2.))
+#define RUN_RANGE   ((float)((RUN_LEG_MAX  - RUN_LEG_MIN ) / 2.))
+
+// fewer sheep are not worth a job
+#define SHEEP_PER_JOB 256
+
+// -------------------------------------------------------------------------
+// turns(phase) : position of 'phase' within the cycle, within [-0.5, 0.5[
+//
+// notes : computed in double precision, the phase keeps growing while the
+//         sheep walks
+// -------------------------------------------------------------------------
+
+static inline float turns(double i_phase)
+{
+  double t = i_phase - floor(i_phase);
+  return (float)(t >= 0.5 ? t - 1. : t);
+}
+
+// -------------------------------------------------------------------------
+// SheepAnimator::Range : sheep of the queue posed by one job
+// -------------------------------------------------------------------------
+
+class SheepAnimator::Range : public Loop
+{
+ public:
+  Range(SheepAnimator* i_animator) :Loop(), mp_animator(i_animator) {}
+
+  virtual void run(int i_begin, int i_end)
+  {
+    mp_animator->evaluate(i_begin, i_end);
+    mp_animator->write(i_begin, i_end);
+  }
+
+ private:
+  SheepAnimator* mp_animator;
+};
+
+SheepAnimator::SheepAnimator()
+  :Physics::Moved(),
+   mp_scheduler(0),
+   m_mutex(),
+   m_queue()
+{
+}
+
+SheepAnimator::~SheepAnimator()
+{
+  clear();
+}
+
+// -------------------------------------------------------------------------
+// queue(sheep), unqueue(sheep), clear() : sheep waiting for a new pose
+//
+// notes : a sheep is only recorded once, whatever how many times its
+//         phase changed since the last update()
+// -------------------------------------------------------------------------
+
+void SheepAnimator::queue(Sheep* i_sheep)
+{
+  QMutexLocker lock(&m_mutex);
+  if (!i_sheep->m_queued) {
+    i_sheep->m_queued = true;
+    m_queue.push_back(i_sheep);
+  }
+}
+
+void SheepAnimator::unqueue(Sheep* i_sheep)
+{
+  QMutexLocker lock(&m_mutex);
+  if (i_sheep->m_queued) {
+    i_sheep->m_queued = false;
+    vec_sheep::iterator it =
+      std::find(m_queue.begin(), m_queue.end(), i_sheep);
+    if (it != m_queue.end()) m_queue.erase(it);
+  }
+}
+
+void SheepAnimator::clear()
+{
+  QMutexLocker lock(&m_mutex);
+  for (vec_sheep::iterator it = m_queue.begin(); it != m_queue.end(); it++)
+    (*it)->m_queued = false;
+  m_queue.clear();
+}
+
+void SheepAnimator::setScheduler(Scheduler* i_scheduler)
+{
+  mp_scheduler = i_scheduler;
+}
+
+// -------------------------------------------------------------------------
+// update() : animate all the recorded sheep
+//
+// notes : the arrays keep their capacity from one update to the next,
+//         there is no allocation once the herd size is stable. each sheep
+//         is posed independently, in any order.
+// -------------------------------------------------------------------------
+
+void SheepAnimator::update()
+{
+  int count = (int)m_queue.size();
+  if (count == 0) return;
+
+  // gather the animation state of each sheep
+  vec_floats* arrays[] = {
+    &m_turns, &m_half_turns, &m_walking, &m_sin, &m_cos,
+    &m_half_sin, &m_half_cos, &m_leg_a, &m_leg_b, &m_rock,
+    &m_leg_a_sin, &m_leg_a_cos, &m_leg_b_sin, &m_leg_b_cos,
+    &m_rock_sin, &m_rock_cos };
+  for (unsigned int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+    if ((int)arrays[i]->size() < count) arrays[i]->resize(count);
+
+  for (int i = 0; i < count; i++) {
+    const Sheep* s = m_queue[i];
+    m_turns[i]      = turns(s->m_phase);
+    m_half_turns[i] = turns(s->m_phase / 2.);
+    m_walking[i]    = (s->m_walking ? 1.f : 0.f);
+  }
+
+  if (mp_scheduler) {
+    Range range(this);
+    mp_scheduler->parallelFor(count, range, SHEEP_PER_JOB);
+  }
+  else {
+    evaluate(0, count);
+    write(0, count);
+  }
+  clear();
+}
+
+void SheepAnimator::moved()
+{
+  update();
+}
+
+// -------------------------------------------------------------------------
+// evaluate(begin, end) : leg, rock and breath curves of the gathered sheep
+//
+// notes : same curves as Sheep::setAnimationPhase, without branches so
+//         each loop works on several sheep at once
+// -------------------------------------------------------------------------
+
+void SheepAnimator::evaluate(int i_begin, int i_end)
+{
+  int    f  = i_begin, i_count = i_end - i_begin;
+  float* t  = &m_turns[f];
+  float* w  = &m_walking[f];
+  float* la = &m_leg_a[f];
+  float* lb = &m_leg_b[f];
+
+  // the second pair of legs is late by WALK_OFFSET or RUN_OFFSET
+  // (m_leg_b and m_leg_b_sin first hold their phase and its sin)
+  for (int i = 0; i < i_count; i++) {
+    float o = w[i] * (float)WALK_OFFSET + (1.f - w[i]) * (float)RUN_OFFSET;
+    float b = t[i] + o;
+    lb[i] = (b >= 0.5f ? b - 1.f : b);
+  }
+  sinCos(t,  &m_sin[f],    &m_cos[f],    i_count);
+  sinCos(lb, &m_leg_b_sin[f], &m_leg_b_cos[f], i_count);
+  sinCos(&m_half_turns[f], &m_half_sin[f], &m_half_cos[f], i_count);
+
+  // leg positions, then angles (in turns). while running, the sin curve
+  // is cut so the legs remain a little bit motionless while at the back,
+  // and hind legs have their ranges inversed.
+  float* sa = &m_sin[f];
+  float* sb = &m_leg_b_sin[f];
+  float* r  = &m_rock[f];
+  for (int i = 0; i < i_count; i++) {
+    float pa = std::max(sa[i] * 1.5f - 0.5f, -1.f);
+    float pb = std::max(sb[i] * 1.5f - 0.5f, -1.f);
+    pa = w[i] * sa[i] + (1.f - w[i]) * pa;
+    pb = w[i] * sb[i] + (1.f - w[i]) * pb;
+
+    float center = w[i] * WALK_CENTER + (1.f - w[i]) * RUN_CENTER;
+    float range  = w[i] * WALK_RANGE  + (1.f - w[i]) * RUN_RANGE;
+    la[i] = (center + range * pa) / 360.f;
+    lb[i] = (w[i] * WALK_CENTER - (1.f - w[i]) * RUN_CENTER +
+             range * pb) / 360.f;
+
+    // the sheep rocks a little bit (2 degrees)
+    r[i] = (sa[i] * 2.f) / 360.f;
+  }
+  sinCos(la, &m_leg_a_sin[f], &m_leg_a_cos[f], i_count);
+  sinCos(lb, &m_leg_b_sin[f], &m_leg_b_cos[f], i_count);
+  sinCos(r,  &m_rock_sin[f],  &m_rock_cos[f],  i_count);
+}
+
+// -------------------------------------------------------------------------
+// write(begin, end) : write the poses into the body parts transforms
+//
+// notes : the rotations are the matrices Transform::setRotation and
+//         addRotation would build (already transposed for glMultMatrix)
+// -------------------------------------------------------------------------
+
+void SheepAnimator::write(int i_begin, int i_end)
+{
+  for (int i = i_begin; i < i_end; i++) {
+    Sheep* s = m_queue[i];
+
+    // body scaled to simulate subtle breathing (two breathes per cycle)
+    double b = m_half_cos[i];
+    s->mp_body->transform().setScaling
+      (Vector(1., 0.7 * (1. + (b * 0.02)), 0.7 * (1. - (b * 0.02))));
+
+    // rocking : rotation around i
+    double rc = m_rock_cos[i], rs = m_rock_sin[i];
+    s->mp_sheep->transform().setRotation
+      (Matrix(1., 0., 0., 0.,
+              0., rc, rs, 0.,
+              0.,-rs, rc, 0.,
+              0., 0., 0., 1.));
+
+    // legs : 90 degrees around i, then the leg angle around k
+    if (!s->m_waiting) {
+      double ac = m_leg_a_cos[i], as = m_leg_a_sin[i];
+      double bc = m_leg_b_cos[i], bs = m_leg_b_sin[i];
+      Matrix a(ac, as, 0., 0.,  0., 0., 1., 0.,  as,-ac, 0., 0.,
+               0., 0., 0., 1.);
+      Matrix c(bc, bs, 0., 0.,  0., 0., 1., 0.,  bs,-bc, 0., 0.,
+               0., 0., 0., 1.);
+
+      // walking : diagonal pairs, running : front and back pairs
+      s->mp_leg[0][0]->transform().setRotation(a);
+      s->mp_leg[1][0]->transform().setRotation(c);
+      s->mp_leg[0][1]->transform().setRotation(s->m_walking ? c : a);
+      s->mp_leg[1][1]->transform().setRotation(s->m_walking ? a : c);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------
+// sinCos(turns, sin, cos, count) : sin and cos of (2 * pi * turns)
+//
+// notes : turns are folded within [-0.25, 0.25] and a polynomial
+//         (taylor series up to x^11, error < 1e-7) is evaluated. written
+//         as plain loops without branches so the compiler vectorizes them.
+// -------------------------------------------------------------------------
+
+static inline float sinTurns(float x)
+{
+  x = (x >  0.25f ?  0.5f - x : x);
+  x = (x < -0.25f ? -0.5f - x : x);
+  float a  = x * (float)(2. * M_PI);
+  float a2 = a * a;
+  return a * (1.f + a2 * (-1.f / 6.f + a2 * (1.f / 120.f +
+         a2 * (-1.f / 5040.f + a2 * (1.f / 362880.f +
+         a2 * (-1.f / 39916800.f))))));
+}
+
+void SheepAnimator::sinCos(const float* i_turns, float* o_sin, float* o_cos,
+                           int i_count)
+{
+  for (int i = 0; i < i_count; i++)
+    o_sin[i] = sinTurns(i_turns[i]);
+
+  // cos(x) = sin(x + 1/4 turn)
+  for (int i = 0; i < i_count; i++) {
+    float c = i_turns[i] + 0.25f;
+    o_cos[i] = sinTurns(c >= 0.5f ? c - 1.f : c);
+  }
+}
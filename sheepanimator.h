@@ -0,0 +1,98 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SHEEPANIMATOR_H
+#define SHEEPANIMATOR_H
+class   SheepAnimator;
+
+class Sheep;
+#include "physics.h"
+#include "scheduler.h"
+#include <QMutex>
+#include <vector>
+
+class SheepAnimator : public Physics::Moved
+//
+// SheepAnimator : animate many sheep at once
+//
+//   a sheep given an animator (see Sheep::setAnimator) only records its
+//   new animation phase. the animator then evaluates the leg, rock and
+//   breath curves of all the recorded sheep together, in loops over
+//   arrays of phases (polynomial sin / cos the compiler can vectorize),
+//   and writes the resulting poses straight into the body parts
+//   transforms.
+//
+//   sheep may be recorded from several threads at once, and with a
+//   scheduler the poses are evaluated and written by all its threads.
+//
+{
+ public:
+  SheepAnimator();
+  virtual ~SheepAnimator();
+
+  // record a sheep whose animation phase changed, or forget about it
+  void queue(Sheep* i_sheep);
+  void unqueue(Sheep* i_sheep);
+  void clear();
+
+  // run the updates on a scheduler (0 -> on the calling thread)
+  void setScheduler(Scheduler* i_scheduler);
+
+  // animate all the recorded sheep
+  void update();
+
+  // same as update() (run by Physics::tick between its steps)
+  virtual void moved();
+
+  // sin and cos of (2 * pi * turns), for turns within [-0.5, 0.5]
+  static void sinCos(const float* i_turns, float* o_sin, float* o_cos,
+                     int i_count);
+
+ private:
+  typedef std::vector<Sheep*> vec_sheep;
+  typedef std::vector<float>  vec_floats;
+
+  class Range;
+  friend class Range;
+
+  // sheep [begin, end[ of the queue
+  void evaluate(int i_begin, int i_end);
+  void write(int i_begin, int i_end);
+
+  Scheduler* mp_scheduler;  // 0 -> update on the calling thread
+  QMutex     m_mutex;       // protects the queue
+  vec_sheep  m_queue;       // sheep waiting for their new pose
+
+  // one entry per queued sheep
+  vec_floats m_turns;       // phase within [-0.5, 0.5[
+  vec_floats m_half_turns;  // phase / 2 within [-0.5, 0.5[ (breathing)
+  vec_floats m_walking;     // 1 : walking, 0 : running
+  vec_floats m_sin, m_cos;  // of the phase
+  vec_floats m_half_sin, m_half_cos;
+  vec_floats m_leg_a;       // leg angles (turns)
+  vec_floats m_leg_b;
+  vec_floats m_rock;        // rocking angle (turns)
+  vec_floats m_leg_a_sin, m_leg_a_cos;
+  vec_floats m_leg_b_sin, m_leg_b_cos;
+  vec_floats m_rock_sin,  m_rock_cos;
+};
+
+#endif // SHEEPANIMATOR_H
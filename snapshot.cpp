@@ -0,0 +1,194 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "snapshot.h"
+#include <QFile>
+#include <QString>
+#include <cstring>
+
+#define SNAPSHOT_MAGIC      "SHEEPSNP"
+#define SNAPSHOT_VERSION    3
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_ALIGN      8
+
+// size of one body entry (texture hash entries for TEXTURE_HASH)
+static const int ELEMENT_SIZE[Snapshot::ARRAYS] = {
+  sizeof(qint32),      // KIND
+  sizeof(qint32),      // FLAGS
+  sizeof(qint32),      // TARGET
+  sizeof(qint32),      // VICTIM
+  sizeof(qint32),      // TEXTURE
+  sizeof(double),      // SIZE
+  sizeof(double) * 3,  // POSITION
+  sizeof(double) * 3,  // VELOCITY
+  sizeof(double) * 16, // ROTATION
+  sizeof(double) * 3,  // SCALING
+  sizeof(double),      // PHASE
+  sizeof(double),      // ORIENTATION
+  sizeof(quint64),     // TEXTURE_HASH
+  sizeof(qint32) * 2,  // CONTACT_PAIR
+  sizeof(double) * 4   // CONTACT_IMPULSE
+};
+
+Snapshot::Snapshot()
+  :m_buffer(),
+   mp_file(0),
+   mp_data(0)
+{
+}
+
+Snapshot::~Snapshot()
+{
+  clear();
+}
+
+// -------------------------------------------------------------------------
+// layout(bodies, textures, contacts, offsets) : where each array goes in
+//                                              the file
+//
+// return value : total snapshot size
+// -------------------------------------------------------------------------
+
+quint64 Snapshot::layout(quint32 i_bodies, quint32 i_textures,
+                         quint32 i_contacts, quint64 o_offsets[ARRAYS])
+{
+  quint64 offset = sizeof(SnapshotHeader);
+  for (int i = 0; i < ARRAYS; i++) {
+    offset = (offset + SNAPSHOT_ALIGN - 1) & ~(quint64)(SNAPSHOT_ALIGN - 1);
+    o_offsets[i] = offset;
+    quint32 count = i_bodies;
+    if (i == TEXTURE_HASH) count = i_textures;
+    if ((i == CONTACT_PAIR) || (i == CONTACT_IMPULSE)) count = i_contacts;
+    offset += (quint64)ELEMENT_SIZE[i] * count;
+  }
+  return offset;
+}
+
+// -------------------------------------------------------------------------
+// create(bodies, textures, contacts) : new snapshot to be filled then
+//                                     saved
+// -------------------------------------------------------------------------
+
+void Snapshot::create(int i_bodies, int i_textures, int i_contacts)
+{
+  clear();
+
+  quint64 offsets[ARRAYS];
+  quint64 size = layout(i_bodies, i_textures, i_contacts, offsets);
+  m_buffer.resize((int)size);
+  memset(m_buffer.data(), 0, (size_t)size);
+  mp_data = (const uchar*)m_buffer.constData();
+
+  SnapshotHeader& h = header();
+  memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+  for (int i = 0; i < ARRAYS; i++) h.offsets[i] = offsets[i];
+  h.size      = size;
+  h.byteOrder = SNAPSHOT_BYTE_ORDER;
+  h.version   = SNAPSHOT_VERSION;
+  h.bodies    = i_bodies;
+  h.textures  = i_textures;
+  h.contacts  = i_contacts;
+}
+
+bool Snapshot::save(const QString& i_file) const
+{
+  if (m_buffer.isEmpty()) return false;
+
+  QFile f(i_file);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  return (f.write(m_buffer) == m_buffer.size());
+}
+
+// -------------------------------------------------------------------------
+// map(file) : map a snapshot file, read only
+//
+// notes : the header is checked (magic, version, byte order, layout), the
+//         arrays are then used as they are in the file
+// -------------------------------------------------------------------------
+
+bool Snapshot::map(const QString& i_file)
+{
+  clear();
+
+  mp_file = new QFile(i_file);
+  if (mp_file->open(QIODevice::ReadOnly) &&
+      (mp_file->size() >= (qint64)sizeof(SnapshotHeader)))
+    mp_data = mp_file->map(0, mp_file->size());
+
+  if (mp_data) {
+    const SnapshotHeader& h = header();
+    quint64 offsets[ARRAYS];
+    bool valid =
+      (memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) == 0) &&
+      (h.byteOrder == SNAPSHOT_BYTE_ORDER) &&
+      (h.version   == SNAPSHOT_VERSION) &&
+      (h.size      == (quint64)mp_file->size()) &&
+      (layout(h.bodies, h.textures, h.contacts, offsets) == h.size);
+    for (int i = 0; valid && (i < ARRAYS); i++)
+      valid = (h.offsets[i] == offsets[i]);
+    if (valid) return true;
+  }
+
+  clear();
+  return false;
+}
+
+void Snapshot::clear()
+{
+  if (mp_file) {
+    if (mp_data) mp_file->unmap((uchar*)mp_data);
+    delete mp_file; mp_file = 0;
+  }
+  m_buffer = QByteArray();
+  mp_data = 0;
+}
+
+bool Snapshot::isValid() const
+{
+  return (mp_data != 0);
+}
+
+// -------------------------------------------------------------------------
+// header(), array(array) : access to the snapshot data
+//
+// notes : a mapped snapshot is read only, only a created snapshot can be
+//         modified
+// -------------------------------------------------------------------------
+
+const SnapshotHeader& Snapshot::header() const
+{
+  return *((const SnapshotHeader*)mp_data);
+}
+
+SnapshotHeader& Snapshot::header()
+{
+  return *((SnapshotHeader*)mp_data);
+}
+
+const void* Snapshot::array(Array i_array) const
+{
+  return mp_data + header().offsets[i_array];
+}
+
+void* Snapshot::array(Array i_array)
+{
+  return (uchar*)mp_data + header().offsets[i_array];
+}
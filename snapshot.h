@@ -0,0 +1,129 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+class   Snapshot;
+
+class QFile;
+class QString;
+#include <QtGlobal>
+#include <QByteArray>
+
+struct SnapshotHeader
+//
+// SnapshotHeader : first bytes of a snapshot file
+//
+//   all the values are in the byte order of the machine that saved the
+//   snapshot. 64 bits values come first so that there is no padding.
+//
+{
+  char    magic[8];         // "SHEEPSNP"
+  quint64 offsets[16];      // file offset of each Snapshot::Array
+  quint64 size;             // total file size
+  quint64 seed;             // scene random generator seed
+  quint64 random[3];        // scene random generator state
+  double  limitGrass;       // scene parameters
+  double  bigBallAccel;
+  double  worldRadius;
+  double  spawnPoint[3];
+  double  restitution;
+  double  friction;
+  double  seconds;          // scene statistics
+  double  timeSurvived;
+  quint32 byteOrder;        // 0x01020304, as written by the machine
+  quint32 version;          // SNAPSHOT_VERSION
+  quint32 bodies;           // number of bodies (scene children)
+  quint32 textures;         // number of texture references
+  quint32 contacts;         // number of contact solver impulses
+  qint32  maximumSheep;     // scene parameters
+  qint32  solverIterations;
+  qint32  sheepCounter;     // scene state
+  qint32  currentVictim;    // closest to the Big Red Ball (not read)
+  qint32  evilBigBall;
+  qint32  collisions;       // scene statistics
+  qint32  victimsHit;
+};
+
+class Snapshot
+//
+// Snapshot : flat, versioned, binary scene snapshot
+//
+//   - a header followed by one array per body attribute (structure of
+//     arrays), each array is 8 bytes aligned
+//   - textures are referenced by the hash of their image
+//   - a snapshot file is read through a memory mapping, the arrays are
+//     used in place (no copy, no parsing)
+//
+{
+ public:
+  // body attribute arrays (and the texture hash table)
+  enum Array {
+    KIND,         // qint32       BodyKind
+    FLAGS,        // qint32       BodyFlags
+    TARGET,       // qint32       scene target id (-1 if none)
+    VICTIM,       // qint32       index in the victims (-1 if none)
+    TEXTURE,      // qint32       index in TEXTURE_HASH (-1 if none)
+    SIZE,         // double       sheep body length, ball radius
+    POSITION,     // double[3]
+    VELOCITY,     // double[3]
+    ROTATION,     // double[16]   rotation matrix (as in Matrix)
+    SCALING,      // double[3]
+    PHASE,        // double       sheep animation phase
+    ORIENTATION,  // double       sheep orientation (degrees)
+    TEXTURE_HASH, // quint64      one entry per texture (not per body)
+    CONTACT_PAIR, // qint32[2]    bodies (-1 : the world limits), one
+                  //              entry per contact solver impulse
+    CONTACT_IMPULSE, // double[4] normal impulse, then friction impulse
+    ARRAYS
+  };
+  enum BodyKind  { SHEEP = 0, BALL = 1 };
+  enum BodyFlags { MOVABLE = 1, WALKING = 2, WAITING = 4, BIG_BALL = 8 };
+
+  Snapshot();
+  ~Snapshot();
+
+  // new snapshot to be filled then saved
+  void create(int i_bodies, int i_textures, int i_contacts = 0);
+  bool save(const QString& i_file) const;
+
+  // map a snapshot file, read only ('false' if it isn't a valid snapshot)
+  bool map(const QString& i_file);
+
+  void clear();
+  bool isValid() const;
+
+  // header and arrays (only created snapshots can be modified)
+  const SnapshotHeader& header() const;
+  SnapshotHeader& header();
+  const void* array(Array i_array) const;
+  void* array(Array i_array);
+
+ private:
+  static quint64 layout(quint32 i_bodies, quint32 i_textures,
+                        quint32 i_contacts, quint64 o_offsets[ARRAYS]);
+
+  QByteArray   m_buffer;  // created snapshot data
+  QFile*       mp_file;   // mapped snapshot file (0 if none)
+  const uchar* mp_data;   // snapshot data (buffer or mapping)
+};
+
+#endif // SNAPSHOT_H
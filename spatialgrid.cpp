@@ -0,0 +1,416 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "spatialgrid.h"
+#include "globject.h"
+#include "boundingsphere.h"
+#include "ray.h"
+#include "scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+#define CELL_SIZE      4.     // smallest cell (m), a few sheep in each
+#define MAX_CELLS      256    // more cells on a side -> larger cells
+#define LINEAR_SEARCH  32     // fewer globjects -> no need for the grid
+#define FAR_AWAY       1.e300 // no hit yet
+#define ENTRIES_PER_JOB 256   // fewer spheres to read are not worth a job
+
+// -------------------------------------------------------------------------
+// keep(best, count, distance, entry) : keep an entry if it is among the
+//                                      'count' closest found so far
+// -------------------------------------------------------------------------
+
+typedef std::pair<double, int>  Candidate;
+typedef std::vector<Candidate>  vec_candidates;
+
+static void keep(vec_candidates& io_best, int i_count,
+                 double i_distance, int i_entry)
+{
+  if (((int)io_best.size() == i_count) &&
+      (i_distance >= io_best.back().first))
+    return;
+
+  Candidate c(i_distance, i_entry);
+  io_best.insert(std::upper_bound(io_best.begin(), io_best.end(), c), c);
+  if ((int)io_best.size() > i_count) io_best.pop_back();
+}
+
+// -------------------------------------------------------------------------
+// SpatialGrid::Spheres : read the bounding spheres of a range of entries
+// -------------------------------------------------------------------------
+
+class SpatialGrid::Spheres : public Loop
+{
+ public:
+  Spheres(vec_entries& io_entries) :Loop(), m_entries(io_entries) {}
+
+  virtual void run(int i_begin, int i_end)
+  {
+    for (int i = i_begin; i < i_end; i++) {
+      Entry& e = m_entries[i];
+      BoundingSphere bs = e.object->boundingSphere();
+      e.center = bs.center();
+      e.radius = bs.radius();
+    }
+  }
+
+ private:
+  vec_entries& m_entries;
+};
+
+SpatialGrid::SpatialGrid()
+  :m_limit(0.),
+   m_center_x(0.),
+   m_center_z(0.),
+   m_cell(CELL_SIZE),
+   m_side(0),
+   m_radius(0.),
+   m_entries(),
+   m_index(),
+   m_cells()
+{
+  setLimit(0.);
+}
+
+// -------------------------------------------------------------------------
+// setLimit(limit), setCenter(x, z) : the grid covers the (2 * limit)^2
+//                                   square around (x, z)
+//
+// notes : globjects beyond the limits are kept in the border cells
+// -------------------------------------------------------------------------
+
+void SpatialGrid::setLimit(double i_limit)
+{
+  m_limit = i_limit;
+  m_cell  = CELL_SIZE;
+  if (2. * m_limit / m_cell > MAX_CELLS) m_cell = 2. * m_limit / MAX_CELLS;
+  m_side  = (int)ceil(2. * m_limit / m_cell);
+  if (m_side < 1) m_side = 1;
+
+  m_cells.assign(m_side * m_side, vec_cell());
+  for (unsigned int i = 0; i < m_entries.size(); i++) {
+    if (m_entries[i].cell < 0) continue;
+    m_entries[i].cell = -1;
+    moveEntry(i, cellX(m_entries[i].center.x()) +
+                 cellZ(m_entries[i].center.z()) * m_side);
+  }
+}
+
+void SpatialGrid::setCenter(double i_x, double i_z)
+{
+  if ((m_center_x == i_x) && (m_center_z == i_z)) return;
+  m_center_x = i_x;
+  m_center_z = i_z;
+  setLimit(m_limit);
+}
+
+// -------------------------------------------------------------------------
+// insert(globject), remove(globject), clear() : indexed globjects
+//
+// notes : the globjects are not owned by the grid
+// -------------------------------------------------------------------------
+
+void SpatialGrid::insert(Globject* i_object)
+{
+  if (contains(i_object)) return;
+
+  Entry e;
+  e.object = i_object;
+  e.radius = 0.;
+  e.cell   = -1;
+  m_index.insert(map_entries::value_type(i_object, m_entries.size()));
+  m_entries.push_back(e);
+}
+
+bool SpatialGrid::remove(const Globject* i_object)
+{
+  map_entries::iterator it = m_index.find(i_object);
+  if (it == m_index.end()) return false;
+  int k = (*it).second;
+  m_index.erase(it);
+  moveEntry(k, -1);
+
+  // the last entry takes the place of the removed one
+  int last = m_entries.size() - 1;
+  if (k != last) {
+    m_entries[k] = m_entries[last];
+    m_index[m_entries[k].object] = k;
+    if (m_entries[k].cell >= 0) {
+      vec_cell& cell = m_cells[m_entries[k].cell];
+      *std::find(cell.begin(), cell.end(), last) = k;
+    }
+  }
+  m_entries.pop_back();
+  return true;
+}
+
+bool SpatialGrid::contains(const Globject* i_object) const
+{
+  return (m_index.find(i_object) != m_index.end());
+}
+
+void SpatialGrid::clear()
+{
+  m_entries.clear();
+  m_index.clear();
+  m_cells.assign(m_side * m_side, vec_cell());
+  m_radius = 0.;
+}
+
+int SpatialGrid::size() const
+{
+  return m_entries.size();
+}
+
+// -------------------------------------------------------------------------
+// update(scheduler) : read the bounding spheres again
+//
+// notes : only the globjects that changed of cell are moved, the queries
+//         use the bounding spheres as of the last update. the spheres are
+//         read by all the scheduler threads, the cells are updated here.
+// -------------------------------------------------------------------------
+
+void SpatialGrid::update(Scheduler* i_scheduler)
+{
+  Spheres spheres(m_entries);
+  if (i_scheduler)
+    i_scheduler->parallelFor(m_entries.size(), spheres, ENTRIES_PER_JOB);
+  else
+    spheres.run(0, m_entries.size());
+
+  m_radius = 0.;
+  for (unsigned int i = 0; i < m_entries.size(); i++) {
+    Entry& e = m_entries[i];
+    if (e.radius > m_radius) m_radius = e.radius;
+
+    int cell = cellX(e.center.x()) + cellZ(e.center.z()) * m_side;
+    if (cell != e.cell) moveEntry(i, cell);
+  }
+}
+
+// -------------------------------------------------------------------------
+// nearest(point, count, found, except) : the 'count' globjects with the
+//                                        closest bounding sphere centers
+//
+// except       : if non-null, this globject is never found
+// return value : how many were found (all of them if there are fewer)
+//
+// notes : the cells are searched in growing rings around the point,
+//         until no other ring can be closer than what was found
+// -------------------------------------------------------------------------
+
+int SpatialGrid::nearest(const Vector& i_point, int i_count,
+                         vec_globject& o_found, const Globject* i_except) const
+{
+  o_found.clear();
+  if (i_count <= 0) return 0;
+
+  vec_candidates best;
+  if (m_entries.size() <= LINEAR_SEARCH) {
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+      if ((m_entries[i].cell >= 0) && (m_entries[i].object != i_except))
+        keep(best, i_count, (m_entries[i].center - i_point).l2norm(), i);
+  }
+  else {
+    int cx = cellX(i_point.x());
+    int cz = cellZ(i_point.z());
+
+    // the point may be outside the grid, the rings are farther then
+    double ox = fabs(i_point.x() - m_center_x) - m_limit;
+    double oz = fabs(i_point.z() - m_center_z) - m_limit;
+    if (ox < 0.) ox = 0.;
+    if (oz < 0.) oz = 0.;
+    double outside = sqrt(ox * ox + oz * oz);
+
+    for (int r = 0; r <= m_side; r++) {
+      if (((int)best.size() == i_count) &&
+          (best.back().first <= (r - 1) * m_cell - outside))
+        break;
+
+      for (int z = cz - r; z <= cz + r; z++) {
+        if ((z < 0) || (z >= m_side)) continue;
+        // only the border of the ring (the inside was already searched)
+        int step = (((z == cz - r) || (z == cz + r)) ? 1 : 2 * r);
+        for (int x = cx - r; x <= cx + r; x += step) {
+          if ((x < 0) || (x >= m_side)) continue;
+          const vec_cell& cell = m_cells[x + z * m_side];
+          for (unsigned int i = 0; i < cell.size(); i++) {
+            const Entry& e = m_entries[cell[i]];
+            if (e.object != i_except)
+              keep(best, i_count, (e.center - i_point).l2norm(), cell[i]);
+          }
+        }
+      }
+    }
+  }
+
+  for (unsigned int i = 0; i < best.size(); i++)
+    o_found.push_back(m_entries[best[i].second].object);
+  return o_found.size();
+}
+
+// -------------------------------------------------------------------------
+// within(point, radius, found) : globjects touching a sphere
+//
+// return value : how many were found
+// -------------------------------------------------------------------------
+
+int SpatialGrid::within(const Vector& i_point, double i_radius,
+                        vec_globject& o_found) const
+{
+  o_found.clear();
+  double reach = i_radius + m_radius;
+  int x0 = cellX(i_point.x() - reach), x1 = cellX(i_point.x() + reach);
+  int z0 = cellZ(i_point.z() - reach), z1 = cellZ(i_point.z() + reach);
+
+  for (int z = z0; z <= z1; z++)
+    for (int x = x0; x <= x1; x++) {
+      const vec_cell& cell = m_cells[x + z * m_side];
+      for (unsigned int i = 0; i < cell.size(); i++) {
+        const Entry& e = m_entries[cell[i]];
+        if ((e.center - i_point).l2norm() <= i_radius + e.radius)
+          o_found.push_back(e.object);
+      }
+    }
+  return o_found.size();
+}
+
+// -------------------------------------------------------------------------
+// rayCast(ray, distance) : first bounding sphere on a ray
+//
+// distance     : if non-null, set to the distance to the hit
+// return value : the globject hit, 0 -> none
+//
+// notes : the cells are visited along the ray (within the grid), each
+//         one with its neighbours as far as the largest radius. no
+//         sphere can be hit closer once a cell is entered past a hit.
+// -------------------------------------------------------------------------
+
+Globject* SpatialGrid::rayCast(const Ray& i_ray, double* o_distance) const
+{
+  const Vector& origin = i_ray.origin();
+  const Vector& dir    = i_ray.direction();
+  if (dir.l2norm() == 0.) return 0;
+
+  // part of the ray over the grid
+  double center[3] = { m_center_x, 0., m_center_z };
+  double t0 = 0., t1 = FAR_AWAY;
+  for (int a = 0; a < 3; a += 2) {
+    if (dir[a] == 0.) {
+      if (fabs(origin[a] - center[a]) > m_limit) return 0;
+      continue;
+    }
+    double ta = (center[a] - m_limit - origin[a]) / dir[a];
+    double tb = (center[a] + m_limit - origin[a]) / dir[a];
+    if (ta > tb) std::swap(ta, tb);
+    if (ta > t0) t0 = ta;
+    if (tb < t1) t1 = tb;
+  }
+  if (t0 > t1) return 0;
+
+  Vector start = origin + dir * t0;
+  int x  = cellX(start.x()), z = cellZ(start.z());
+  int sx = (dir.x() > 0. ? 1 : -1);
+  int sz = (dir.z() > 0. ? 1 : -1);
+
+  // distance to the next cell border, and between two borders
+  double tx = FAR_AWAY, dtx = FAR_AWAY;
+  double tz = FAR_AWAY, dtz = FAR_AWAY;
+  if (dir.x() != 0.) {
+    tx  = (m_center_x - m_limit + (x + (sx > 0 ? 1 : 0)) * m_cell -
+           origin.x()) / dir.x();
+    dtx = m_cell / fabs(dir.x());
+  }
+  if (dir.z() != 0.) {
+    tz  = (m_center_z - m_limit + (z + (sz > 0 ? 1 : 0)) * m_cell -
+           origin.z()) / dir.z();
+    dtz = m_cell / fabs(dir.z());
+  }
+
+  int margin = (int)ceil(m_radius / m_cell);
+  double    entered = t0;
+  double    best    = FAR_AWAY;
+  Globject* hit     = 0;
+  while ((entered <= t1) && (entered <= best)) {
+    for (int cz = std::max(z - margin, 0);
+         cz <= std::min(z + margin, m_side - 1); cz++)
+      for (int cx = std::max(x - margin, 0);
+           cx <= std::min(x + margin, m_side - 1); cx++) {
+        const vec_cell& cell = m_cells[cx + cz * m_side];
+        for (unsigned int i = 0; i < cell.size(); i++) {
+          const Entry& e = m_entries[cell[i]];
+          double t_near, t_far;
+          if (!i_ray.intersects(BoundingSphere(e.radius, e.center),
+                                &t_near, &t_far))
+            continue;
+          // the origin may be inside : the ray hits on the way out
+          double t = (t_near >= 0. ? t_near : t_far);
+          if (t < best) { best = t; hit = e.object; }
+        }
+      }
+
+    // next cell along the ray
+    if (tx < tz) { entered = tx; tx += dtx; x += sx; }
+    else         { entered = tz; tz += dtz; z += sz; }
+    if ((x < 0) || (x >= m_side) || (z < 0) || (z >= m_side)) break;
+  }
+
+  if (hit && o_distance) *o_distance = best;
+  return hit;
+}
+
+// -------------------------------------------------------------------------
+// cellX(x), cellZ(z) : grid column / row of a position (clamped)
+// cell(offset)       : the same, for an offset from the center
+// -------------------------------------------------------------------------
+
+int SpatialGrid::cellX(double i_x) const
+{
+  return cell(i_x - m_center_x);
+}
+
+int SpatialGrid::cellZ(double i_z) const
+{
+  return cell(i_z - m_center_z);
+}
+
+int SpatialGrid::cell(double i_offset) const
+{
+  int c = (int)floor((i_offset + m_limit) / m_cell);
+  return (c < 0 ? 0 : (c >= m_side ? m_side - 1 : c));
+}
+
+// -------------------------------------------------------------------------
+// moveEntry(entry, cell) : move an entry to another cell (-1 -> none)
+// -------------------------------------------------------------------------
+
+void SpatialGrid::moveEntry(int i_entry, int i_cell)
+{
+  Entry& e = m_entries[i_entry];
+  if (e.cell >= 0) {
+    vec_cell& cell = m_cells[e.cell];
+    vec_cell::iterator it = std::find(cell.begin(), cell.end(), i_entry);
+    (*it) = cell.back();
+    cell.pop_back();
+  }
+  e.cell = i_cell;
+  if (i_cell >= 0) m_cells[i_cell].push_back(i_entry);
+}
@@ -0,0 +1,105 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+class   SpatialGrid;
+
+class Globject;
+class Ray;
+class Scheduler;
+#include "vector.h"
+#include <map>
+#include <vector>
+
+class SpatialGrid
+//
+// SpatialGrid : globjects sorted in a uniform grid over the floor (x, z),
+//               to find them by distance without looking at all of them
+//
+{
+ public:
+  typedef std::vector<Globject*> vec_globject;
+
+  SpatialGrid();
+
+  // the grid covers the (2 * limit)^2 square around a center (m),
+  // the origin by default
+  void setLimit(double i_limit);
+  void setCenter(double i_x, double i_z);
+
+  // indexed globjects (new ones are only sorted by the next update)
+  void insert(Globject* i_object);
+  bool remove(const Globject* i_object);
+  bool contains(const Globject* i_object) const;
+  void clear();
+  int  size() const;
+
+  // read the bounding spheres again (on all the scheduler threads, if
+  // any), move what changed of cell
+  void update(Scheduler* i_scheduler = 0);
+
+  // the 'count' globjects closest to a point (closest first)
+  int nearest(const Vector& i_point, int i_count, vec_globject& o_found,
+              const Globject* i_except = 0) const;
+
+  // globjects whose bounding sphere touches the sphere (point, radius)
+  int within(const Vector& i_point, double i_radius,
+             vec_globject& o_found) const;
+
+  // first bounding sphere along a ray (0 -> none)
+  Globject* rayCast(const Ray& i_ray, double* o_distance = 0) const;
+
+ private:
+  struct Entry
+  //
+  // Entry : an indexed globject, as of the last update
+  //
+  {
+    Globject* object;
+    Vector    center;   // bounding sphere
+    double    radius;
+    int       cell;     // -1 -> not sorted yet
+  };
+  typedef std::vector<Entry>                 vec_entries;
+  typedef std::vector<int>                   vec_cell;
+  typedef std::map<const Globject*, int>     map_entries;
+
+  class Spheres;
+  friend class Spheres;
+
+  int  cellX(double i_x) const;
+  int  cellZ(double i_z) const;
+  int  cell(double i_offset) const;
+  void moveEntry(int i_entry, int i_cell);
+
+  double      m_limit;      // the grid is (2 * limit)^2 square
+  double      m_center_x;   // around this point of the floor
+  double      m_center_z;
+  double      m_cell;       // size of a cell (m)
+  int         m_side;       // cells on a side
+  double      m_radius;     // largest bounding sphere radius
+  vec_entries m_entries;    // indexed globjects
+  map_entries m_index;      // position of each globject in m_entries
+  std::vector<vec_cell> m_cells; // entries in each cell (x + z * side)
+};
+
+#endif // SPATIALGRID_H
@@ -0,0 +1,131 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "streambuffer.h"
+#include "memorystats.h"
+#include <QtOpenGL>
+#include <cstddef>
+
+#define STREAM_ALIGN 16  // vertices start on multiples of x bytes
+
+StreamBuffer::StreamBuffer(int i_size)
+  :m_buffer(QGLBuffer::VertexBuffer),
+   mp_context(0),
+   m_size(i_size),
+   m_offset(0),
+   m_allocated(0)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+  setAllocated(0);
+}
+
+// -------------------------------------------------------------------------
+// draw(mode, format, vertices, count) : draw 'count' vertices
+//
+// mode   : primitives to draw (GL_TRIANGLES, GL_LINES, etc.)
+// format : vertex format, as for glInterleavedArrays (GL_C4UB_V3F, etc.)
+//
+// notes : without vertex buffers (opengl < 1.5), the vertices are drawn
+//         from client memory
+// -------------------------------------------------------------------------
+
+void StreamBuffer::draw(GLenum i_mode, GLenum i_format,
+                        const void* i_vertices, int i_count)
+{
+  int bytes = i_count * vertexSize(i_format);
+  if (bytes <= 0) return;
+
+  // one buffer per opengl context
+  if (mp_context != QGLContext::currentContext()) {
+    mp_context = QGLContext::currentContext();
+    m_buffer.destroy();
+    setAllocated(0);
+    if (m_buffer.create() && m_buffer.bind()) {
+      m_buffer.setUsagePattern(QGLBuffer::StreamDraw);
+      m_buffer.allocate(m_size);
+      m_buffer.release();
+      setAllocated(m_size);
+    }
+    else m_buffer.destroy();
+    m_offset = 0;
+  }
+
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  if (m_buffer.isCreated()) {
+    m_buffer.bind();
+
+    // ring full : fresh storage (larger if need be)
+    if (m_offset + bytes > m_size) {
+      while (bytes > m_size) m_size *= 2;
+      m_buffer.allocate(m_size);
+      setAllocated(m_size);
+      m_offset = 0;
+    }
+
+    m_buffer.write(m_offset, i_vertices, bytes);
+    glInterleavedArrays(i_format, 0, (const GLvoid*)(size_t)m_offset);
+    glDrawArrays(i_mode, 0, i_count);
+    m_buffer.release();
+
+    m_offset += (bytes + STREAM_ALIGN - 1) & ~(STREAM_ALIGN - 1);
+  }
+  else {
+    glInterleavedArrays(i_format, 0, i_vertices);
+    glDrawArrays(i_mode, 0, i_count);
+  }
+  glPopClientAttrib();
+}
+
+// -------------------------------------------------------------------------
+// setAllocated(bytes) : account for the storage of the buffer
+// -------------------------------------------------------------------------
+
+void StreamBuffer::setAllocated(int i_bytes)
+{
+  if (m_allocated) MemoryStats::freed(MemoryStats::GPU_BUFFER, m_allocated);
+  m_allocated = i_bytes;
+  if (m_allocated) MemoryStats::allocated(MemoryStats::GPU_BUFFER, i_bytes);
+}
+
+int StreamBuffer::vertexSize(GLenum i_format)
+{
+  static const int F = sizeof(GLfloat);
+  switch (i_format) {
+    case GL_V2F:               return  2 * F;
+    case GL_V3F:               return  3 * F;
+    case GL_C4UB_V2F:          return  4 + 2 * F;
+    case GL_C4UB_V3F:          return  4 + 3 * F;
+    case GL_C3F_V3F:           return  6 * F;
+    case GL_N3F_V3F:           return  6 * F;
+    case GL_C4F_N3F_V3F:       return 10 * F;
+    case GL_T2F_V3F:           return  5 * F;
+    case GL_T4F_V4F:           return  8 * F;
+    case GL_T2F_C4UB_V3F:      return  4 + 5 * F;
+    case GL_T2F_C3F_V3F:       return  8 * F;
+    case GL_T2F_N3F_V3F:       return  8 * F;
+    case GL_T2F_C4F_N3F_V3F:   return 12 * F;
+    case GL_T4F_C4F_N3F_V4F:   return 15 * F;
+    default:                   return 0;
+  }
+}
@@ -0,0 +1,61 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+class   StreamBuffer;
+
+#include <QGLBuffer>
+
+class StreamBuffer
+//
+// StreamBuffer : vertex buffer for geometry rebuilt at each frame
+//                (shadows, decals, debug lines)
+//
+//   vertices are appended one after the other in a single vertex buffer,
+//   used as a ring. when the ring is full, its storage is orphaned : the
+//   driver hands out fresh storage while the draws already queued keep
+//   the old one, so writing never waits for the gpu. the buffer grows
+//   when one draw doesn't fit.
+//
+{
+ public:
+  StreamBuffer(int i_size = 256 * 1024);
+  ~StreamBuffer();
+
+  // draw vertices, in one of the glInterleavedArrays formats
+  void draw(GLenum i_mode, GLenum i_format, const void* i_vertices,
+            int i_count);
+
+  // size of a vertex of the given format (bytes, 0 : unknown format)
+  static int vertexSize(GLenum i_format);
+
+ private:
+  void setAllocated(int i_bytes);
+
+  QGLBuffer         m_buffer;   // the ring
+  const QGLContext* mp_context; // context m_buffer was created in
+  int               m_size;     // ring size (bytes)
+  int               m_offset;   // where the next vertices go
+  int               m_allocated; // bytes on the gpu (see MemoryStats)
+};
+
+#endif // STREAMBUFFER_H
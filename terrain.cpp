@@ -0,0 +1,162 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "terrain.h"
+#include "memorystats.h"
+#include <QtOpenGL>
+#include <cmath>
+
+#define TILE_SIZE  10.   // meters covered by the texture
+#define MAX_TILES  256   // more tiles on a side -> larger tiles
+
+Terrain::Terrain()
+  :m_limit(0.),
+   m_center_x(0.),
+   m_center_z(0.),
+   m_vertices(),
+   m_buffer(QGLBuffer::VertexBuffer),
+   mp_context(0),
+   m_allocated(0)
+{
+}
+
+Terrain::~Terrain()
+{
+  setAllocated(0);
+}
+
+void Terrain::setLimit(double i_limit)
+{
+  if (m_limit != i_limit) {
+    m_limit = i_limit;
+    m_vertices.clear();
+    mp_context = 0;
+  }
+}
+
+// -------------------------------------------------------------------------
+// setCenter(x, z) : move the field around a point of the floor
+// contains(x, z)  : is a point of the floor on the field?
+//
+// notes : the mesh is only translated when drawn, it is not built again
+// -------------------------------------------------------------------------
+
+void Terrain::setCenter(double i_x, double i_z)
+{
+  m_center_x = floor(i_x / TILE_SIZE + 0.5) * TILE_SIZE;
+  m_center_z = floor(i_z / TILE_SIZE + 0.5) * TILE_SIZE;
+}
+
+bool Terrain::contains(double i_x, double i_z) const
+{
+  return ((fabs(i_x - m_center_x) <= m_limit) &&
+          (fabs(i_z - m_center_z) <= m_limit));
+}
+
+// -------------------------------------------------------------------------
+// draw() : draw the field of grass
+//
+// notes : the mesh is sent to the gpu once (for each opengl context), then
+//         drawn with a single call. without vertex buffers (opengl < 1.5),
+//         it is drawn from client memory.
+// -------------------------------------------------------------------------
+
+void Terrain::draw()
+{
+  if (m_vertices.empty()) build();
+  if (m_vertices.empty()) return;
+  int count = m_vertices.size() / 5;
+
+  if (mp_context != QGLContext::currentContext()) {
+    mp_context = QGLContext::currentContext();
+    m_buffer.destroy();
+    setAllocated(0);
+    if (m_buffer.create() && m_buffer.bind()) {
+      m_buffer.setUsagePattern(QGLBuffer::StaticDraw);
+      m_buffer.allocate(&m_vertices[0], m_vertices.size() * sizeof(GLfloat));
+      m_buffer.release();
+      setAllocated(m_vertices.size() * sizeof(GLfloat));
+    }
+    else m_buffer.destroy();
+  }
+
+  glPushMatrix();
+  glTranslated(m_center_x, 0., m_center_z);
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  if (m_buffer.isCreated()) {
+    m_buffer.bind();
+    glInterleavedArrays(GL_T2F_V3F, 0, 0);
+  }
+  else glInterleavedArrays(GL_T2F_V3F, 0, &m_vertices[0]);
+
+  glDrawArrays(GL_QUADS, 0, count);
+
+  if (m_buffer.isCreated()) m_buffer.release();
+  glPopClientAttrib();
+  glPopMatrix();
+}
+
+// -------------------------------------------------------------------------
+// build() : tile the field, each tile has texture coordinates within [0, 1]
+//           (tiles at the border are cut, and so is their texture)
+// -------------------------------------------------------------------------
+
+void Terrain::build()
+{
+  double side = 2. * m_limit;
+  if (!(side > 0.)) return;
+
+  double tile = TILE_SIZE;
+  if (side / tile > MAX_TILES) tile = side / MAX_TILES;
+  int tiles = (int)ceil(side / tile);
+
+  m_vertices.reserve(tiles * tiles * 4 * 5);
+  for (int i = 0; i < tiles; i++) {
+    double x0 = -m_limit + i * tile;
+    double x1 = (i == tiles - 1) ? m_limit : x0 + tile;
+    GLfloat u = (GLfloat)((x1 - x0) / tile);
+
+    for (int j = 0; j < tiles; j++) {
+      double z0 = -m_limit + j * tile;
+      double z1 = (j == tiles - 1) ? m_limit : z0 + tile;
+      GLfloat v = (GLfloat)((z1 - z0) / tile);
+
+      // counter-clockwise, seen from above
+      GLfloat quad[] = {
+        0., 0., (GLfloat)x0, 0., (GLfloat)z0,
+        0., v,  (GLfloat)x0, 0., (GLfloat)z1,
+        u,  v,  (GLfloat)x1, 0., (GLfloat)z1,
+        u,  0., (GLfloat)x1, 0., (GLfloat)z0 };
+      m_vertices.insert(m_vertices.end(), quad, quad + 20);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------
+// setAllocated(bytes) : account for the storage of the vertex buffer
+// -------------------------------------------------------------------------
+
+void Terrain::setAllocated(int i_bytes)
+{
+  if (m_allocated) MemoryStats::freed(MemoryStats::GPU_BUFFER, m_allocated);
+  m_allocated = i_bytes;
+  if (m_allocated) MemoryStats::allocated(MemoryStats::GPU_BUFFER, i_bytes);
+}
@@ -0,0 +1,63 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TERRAIN_H
+#define TERRAIN_H
+class   Terrain;
+
+#include <QGLBuffer>
+#include <vector>
+
+class Terrain
+//
+// Terrain : the field of grass, a mesh of square tiles kept in a static
+//           vertex buffer (the current texture repeats once per tile)
+//
+{
+ public:
+  Terrain();
+  ~Terrain();
+
+  // where does the field of grass end? (m, around its center)
+  void setLimit(double i_limit);
+
+  // the field follows a point of the floor (the origin by default),
+  // by whole tiles so the grass stays in place
+  void setCenter(double i_x, double i_z);
+  bool contains(double i_x, double i_z) const;
+
+  // draw the field, at y = 0
+  void draw();
+
+ private:
+  void build();
+  void setAllocated(int i_bytes);
+
+  double               m_limit;    // the field is (2 * limit)^2 square
+  double               m_center_x; // around this point (whole tiles)
+  double               m_center_z;
+  std::vector<GLfloat> m_vertices; // GL_T2F_V3F quads (empty -> to build)
+  QGLBuffer            m_buffer;   // the same, for the gpu
+  const QGLContext*    mp_context; // context m_buffer was created in
+  int                  m_allocated; // bytes on the gpu (see MemoryStats)
+};
+
+#endif // TERRAIN_H
@@ -20,10 +20,14 @@
 */
 
 #include "texture.h"
+#include "textureatlas.h"
 #include "color.h"
+#include "memorystats.h"
 #include <QGLWidget>
 #include <QPixmap>
+#include <QImage>
 #include <QPainter>
+#include <QRadialGradient>
 
 // -------------------------------------------------------------------------
 // Texture(size) - create a new texture
@@ -31,10 +35,19 @@
 // notes : texture size is (size * size) pixels, where size is 2^n
 // -------------------------------------------------------------------------
 
+QGLWidget* Texture::sp_bound_gl = 0; // last texture bound, and where
+qint64     Texture::s_bound_key = 0;
+
 Texture::Texture(int i_size)
   :m_bindmap(),
-   m_pixmap(i_size, i_size)
+   m_pixmap(i_size, i_size),
+   m_bytes((qint64)i_size * i_size * 4),
+   mp_atlas(0),
+   m_atlas_u(0.),
+   m_atlas_v(0.),
+   m_atlas_scale(1.)
 {
+  MemoryStats::allocated(MemoryStats::PIXMAP, m_bytes);
 }
 
 // -------------------------------------------------------------------------
@@ -43,7 +56,9 @@ Texture::Texture(int i_size)
 
 Texture::~Texture()
 {
+  if (mp_atlas) mp_atlas->remove(this);
   deleteTexture();
+  MemoryStats::freed(MemoryStats::PIXMAP, m_bytes);
 }
 
 // -------------------------------------------------------------------------
@@ -55,6 +70,27 @@ QPixmap& Texture::pixmap()
   return m_pixmap;
 }
 
+// -------------------------------------------------------------------------
+// hash() : 64 bits FNV-1a hash of the texture image
+//
+// notes : procedural textures are generated the same way each time, so
+//         their hash identifies them from one run to another
+// -------------------------------------------------------------------------
+
+quint64 Texture::hash() const
+{
+  QImage img = m_pixmap.toImage().convertToFormat(QImage::Format_ARGB32);
+  quint64 h = Q_UINT64_C(14695981039346656037);
+  for (int y = 0; y < img.height(); y++) {
+    const uchar* p = img.scanLine(y);
+    for (int x = 0; x < img.width() * 4; x++) {
+      h ^= p[x];
+      h *= Q_UINT64_C(1099511628211);
+    }
+  }
+  return h;
+}
+
 void Texture::pushAttrib()
 {
   glPushAttrib(GL_ENABLE_BIT);
@@ -62,12 +98,30 @@ void Texture::pushAttrib()
 
 // -------------------------------------------------------------------------
 // bind(QGLWidget*) opengl texture binding, a QGLWidget* is necessary
+//
+// notes : binding the texture already bound does nothing. a texture packed
+//         in an atlas binds the atlas, and the opengl texture matrix maps
+//         its texture coordinates to its place in the atlas (until
+//         popAttrib). the current matrix mode must be GL_MODELVIEW.
 // -------------------------------------------------------------------------
 
 void Texture::bind(QGLWidget* i_gl)
 {
   glEnable(GL_TEXTURE_2D);
+  if (mp_atlas) {
+    mp_atlas->texture()->bind(i_gl);
+    glMatrixMode(GL_TEXTURE);
+    glLoadIdentity();
+    glTranslated(m_atlas_u, m_atlas_v, 0.);
+    glScaled(m_atlas_scale, m_atlas_scale, 1.);
+    glMatrixMode(GL_MODELVIEW);
+    return;
+  }
+
+  if ((sp_bound_gl == i_gl) && (s_bound_key == m_pixmap.cacheKey())) return;
   int id = i_gl->bindTexture(m_pixmap);
+  sp_bound_gl = i_gl;
+  s_bound_key = m_pixmap.cacheKey();
 
   // we assume there is only one valid (i_gl, id) pair per texture
   td_bindmap::iterator it = m_bindmap.find(i_gl);
@@ -75,15 +129,27 @@ void Texture::bind(QGLWidget* i_gl)
     if ((*it).second == id) return;
     ((*it).first)->deleteTexture((*it).second);
     m_bindmap.erase(it);
+    MemoryStats::freed(MemoryStats::GPU_TEXTURE, m_bytes);
   }
   m_bindmap.insert(td_bindmap::value_type(i_gl, id));
+  MemoryStats::allocated(MemoryStats::GPU_TEXTURE, m_bytes);
 }
 
 void Texture::popAttrib()
 {
+  // the texture matrix may have been set for an atlas
+  glMatrixMode(GL_TEXTURE);
+  glLoadIdentity();
+  glMatrixMode(GL_MODELVIEW);
   glPopAttrib();
 }
 
+void Texture::forgetBindings()
+{
+  sp_bound_gl = 0;
+  s_bound_key = 0;
+}
+
 // -------------------------------------------------------------------------
 // newCheckeredTexture(size, color) : size = 2^n
 //
@@ -107,13 +173,41 @@ Texture* Texture::newCheckeredTexture(int i_size, const Color& i_color)
   return t;
 }
 
+// -------------------------------------------------------------------------
+// newBlobTexture(size) : size = 2^n, black disc fading out to its border
+//
+// notes : a new Texture is allocated and should be eventually deleted
+// -------------------------------------------------------------------------
+
+Texture* Texture::newBlobTexture(int i_size)
+{
+  Texture* t = new Texture(i_size);
+  t->pixmap().fill(Qt::transparent);
+  {
+    double r = i_size / 2.;
+    QRadialGradient gradient(r, r, r);
+    gradient.setColorAt(0.0, QColor(0, 0, 0, 255));
+    gradient.setColorAt(0.6, QColor(0, 0, 0, 160));
+    gradient.setColorAt(1.0, QColor(0, 0, 0, 0));
+
+    QPainter p(&(t->pixmap()));
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QBrush(gradient));
+    p.drawEllipse(0, 0, i_size, i_size);
+  }
+  return t;
+}
+
 // -------------------------------------------------------------------------
 // deleteTexture() : free up any QGLWidget binding
 // -------------------------------------------------------------------------
 
 void Texture::deleteTexture()
 {
-  for (td_bindmap::iterator i = m_bindmap.begin(); i != m_bindmap.end(); i++)
+  for (td_bindmap::iterator i = m_bindmap.begin(); i != m_bindmap.end(); i++) {
     ((*i).first)->deleteTexture((*i).second);
+    MemoryStats::freed(MemoryStats::GPU_TEXTURE, m_bytes);
+  }
   m_bindmap.clear();
 }
@@ -25,6 +25,7 @@ class   Texture;
 
 class Color;
 class QGLWidget;
+class TextureAtlas;
 #include <QPixmap>
 #include <map>
 
@@ -43,13 +44,21 @@ class Texture
   // access to the texture pixmap
   QPixmap& pixmap();
 
+  // hash of the texture image (identifies a texture in snapshots)
+  quint64 hash() const;
+
   // opengl texture binding
+  // (a texture packed in an atlas binds the atlas, see TextureAtlas)
   static void pushAttrib();
   void bind(QGLWidget* i_gl);
   static void popAttrib();
 
+  // texture bindings changed behind our back (at the start of a frame)
+  static void forgetBindings();
+
   // various texture generation functions
   static Texture* newCheckeredTexture(int i_size, const Color& i_color);
+  static Texture* newBlobTexture(int i_size);
 
  protected:
   void deleteTexture();
@@ -59,6 +68,15 @@ class Texture
 
   td_bindmap m_bindmap; // used to remember all its past bindings
   QPixmap    m_pixmap;  // QPixmap holding the texture image
+  qint64     m_bytes;   // size of the image (see MemoryStats)
+
+  // where the texture was packed (see TextureAtlas)
+  TextureAtlas* mp_atlas;
+  double     m_atlas_u, m_atlas_v, m_atlas_scale;
+  friend class TextureAtlas;
+
+  static QGLWidget* sp_bound_gl;  // last texture bound, and where
+  static qint64     s_bound_key;
 };
 
 #endif // TEXTURE_H
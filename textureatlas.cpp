@@ -0,0 +1,188 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "textureatlas.h"
+#include <QPainter>
+#include <QPixmap>
+#include <algorithm>
+
+#define ATLAS_GUTTER   4     // texels of wrapped texture around each one
+#define ATLAS_MAX_SIZE 2048  // largest atlas size = x * x
+
+// -------------------------------------------------------------------------
+// largerTexture(a, b) : sort order of the textures to pack
+// -------------------------------------------------------------------------
+
+static bool largerTexture(Texture* a, Texture* b)
+{
+  return (a->pixmap().width() > b->pixmap().width());
+}
+
+TextureAtlas::TextureAtlas()
+  :m_textures(),
+   mp_texture(0)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+  clear();
+}
+
+// -------------------------------------------------------------------------
+// add(texture), remove(texture), clear() : textures to pack
+//
+// notes : a removed texture is bound on its own again. its place in the
+//         atlas stays unused until the next build().
+// -------------------------------------------------------------------------
+
+void TextureAtlas::add(Texture* i_texture)
+{
+  if (i_texture && !contains(i_texture))
+    m_textures.push_back(i_texture);
+}
+
+void TextureAtlas::remove(Texture* i_texture)
+{
+  vec_textures::iterator it =
+    std::find(m_textures.begin(), m_textures.end(), i_texture);
+  if (it != m_textures.end()) {
+    (*it)->mp_atlas = 0;
+    m_textures.erase(it);
+  }
+}
+
+void TextureAtlas::clear()
+{
+  detach();
+  m_textures.clear();
+  delete mp_texture; mp_texture = 0;
+}
+
+bool TextureAtlas::contains(const Texture* i_texture) const
+{
+  return (std::find(m_textures.begin(), m_textures.end(), i_texture) !=
+          m_textures.end());
+}
+
+Texture* TextureAtlas::texture()
+{
+  return mp_texture;
+}
+
+// -------------------------------------------------------------------------
+// build() : pack all the textures in the atlas texture
+//
+// notes : each texture is surrounded by ATLAS_GUTTER texels of itself (as
+//         if it was repeated), so filtering at its borders doesn't bleed
+//         into its neighbours.
+// return value : 'false' if the textures don't fit in ATLAS_MAX_SIZE
+// -------------------------------------------------------------------------
+
+bool TextureAtlas::build()
+{
+  detach();
+  delete mp_texture; mp_texture = 0;
+  if (m_textures.empty()) return true;
+
+  // largest textures first, in the smallest square they fit in
+  vec_textures textures = m_textures;
+  std::sort(textures.begin(), textures.end(), largerTexture);
+
+  int area = 0;
+  for (vec_textures::iterator it = textures.begin();
+       it != textures.end(); it++) {
+    int cell = (*it)->pixmap().width() + 2 * ATLAS_GUTTER;
+    area += cell * cell;
+  }
+  int size = 1;
+  while (size * size < area) size *= 2;
+
+  std::vector<int> x, y;
+  while (!pack(textures, size, x, y))
+    if ((size *= 2) > ATLAS_MAX_SIZE) return false;
+
+  // paint the atlas
+  mp_texture = new Texture(size);
+  {
+    mp_texture->pixmap().fill(Qt::transparent);
+    QPainter p(&(mp_texture->pixmap()));
+    for (unsigned int i = 0; i < textures.size(); i++) {
+      const QPixmap& pixmap = textures[i]->pixmap();
+      int s    = pixmap.width();
+      int cell = s + 2 * ATLAS_GUTTER;
+      int from = (s - (ATLAS_GUTTER % s)) % s;
+      p.drawTiledPixmap(x[i], y[i], cell, cell, pixmap, from, from);
+    }
+  }
+
+  // where the textures are, in texture coordinates (qt binds the images
+  // upside down : the first row is at t = 1)
+  for (unsigned int i = 0; i < textures.size(); i++) {
+    Texture* t = textures[i];
+    double s = t->pixmap().width();
+    t->mp_atlas      = this;
+    t->m_atlas_u     = (x[i] + ATLAS_GUTTER) / (double)size;
+    t->m_atlas_v     = (size - (y[i] + ATLAS_GUTTER) - s) / (double)size;
+    t->m_atlas_scale = s / (double)size;
+  }
+  return true;
+}
+
+// -------------------------------------------------------------------------
+// detach() : the textures are bound on their own again
+// -------------------------------------------------------------------------
+
+void TextureAtlas::detach()
+{
+  for (vec_textures::iterator it = m_textures.begin();
+       it != m_textures.end(); it++)
+    (*it)->mp_atlas = 0;
+}
+
+// -------------------------------------------------------------------------
+// pack(textures, size, x, y) : place the textures on shelves, left to right
+//                              then top to bottom (largest ones first)
+//
+// return value : 'false' if they don't fit in a (size * size) texture
+// -------------------------------------------------------------------------
+
+bool TextureAtlas::pack(const vec_textures& i_textures, int i_size,
+                        std::vector<int>& o_x, std::vector<int>& o_y)
+{
+  o_x.resize(i_textures.size());
+  o_y.resize(i_textures.size());
+
+  int x = 0, y = 0, shelf = 0;
+  for (unsigned int i = 0; i < i_textures.size(); i++) {
+    int cell = i_textures[i]->pixmap().width() + 2 * ATLAS_GUTTER;
+    if (x + cell > i_size) {
+      // next shelf
+      x = 0; y += shelf; shelf = 0;
+    }
+    if ((x + cell > i_size) || (y + cell > i_size)) return false;
+
+    o_x[i] = x; o_y[i] = y;
+    x += cell;
+    if (cell > shelf) shelf = cell;
+  }
+  return true;
+}
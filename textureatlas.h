@@ -0,0 +1,69 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+class   TextureAtlas;
+
+#include "texture.h"
+#include <vector>
+
+class TextureAtlas
+//
+// TextureAtlas : several textures packed in a single one
+//
+//   once build() is done, binding any of the packed textures binds the
+//   atlas instead (see Texture::bind), so a whole frame drawn with
+//   packed textures only needs one texture bind. the texture coordinates
+//   of the packed textures must stay within [0, 1].
+//
+// notes : the packed textures must not be destroyed while they are still
+//         in use, but can be destroyed before the atlas
+//
+{
+ public:
+  TextureAtlas();
+  ~TextureAtlas();
+
+  // textures to pack (build() needs to be called again after a change)
+  void add(Texture* i_texture);
+  void remove(Texture* i_texture);
+  void clear();
+  bool contains(const Texture* i_texture) const;
+
+  // pack all the textures (false -> they don't fit, they stay apart)
+  bool build();
+
+  // the atlas texture (null until built)
+  Texture* texture();
+
+ private:
+  typedef std::vector<Texture*> vec_textures;
+
+  void detach();
+  static bool pack(const vec_textures& i_textures, int i_size,
+                   std::vector<int>& o_x, std::vector<int>& o_y);
+
+  vec_textures m_textures; // textures to pack
+  Texture*     mp_texture; // null until built
+};
+
+#endif // TEXTUREATLAS_H
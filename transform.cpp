@@ -20,6 +20,7 @@
 */
 
 #include "transform.h"
+#include "memorystats.h"
 #include <QtOpenGL>
 #include <cmath>
 
@@ -28,6 +29,20 @@ Transform::Transform()
    m_rotation(),
    m_scaling(1., 1., 1.)
 {
+  MemoryStats::allocated(MemoryStats::TRANSFORM, sizeof(Transform));
+}
+
+Transform::Transform(const Transform& t)
+  :m_translation(t.m_translation),
+   m_rotation(t.m_rotation),
+   m_scaling(t.m_scaling)
+{
+  MemoryStats::allocated(MemoryStats::TRANSFORM, sizeof(Transform));
+}
+
+Transform::~Transform()
+{
+  MemoryStats::freed(MemoryStats::TRANSFORM, sizeof(Transform));
 }
 
 // -------------------------------------------------------------------------
@@ -43,6 +58,23 @@ void Transform::apply() const
   glScaled(m_scaling.x(), m_scaling.y(), m_scaling.z());
 }
 
+// -------------------------------------------------------------------------
+// applyTo(point) : where apply() would take a point
+//
+// note : the rotation matrix is stored for glMultMatrix (transposed)
+// -------------------------------------------------------------------------
+
+Vector Transform::applyTo(const Vector& i_point) const
+{
+  double x = i_point.x() * m_scaling.x();
+  double y = i_point.y() * m_scaling.y();
+  double z = i_point.z() * m_scaling.z();
+  const double* r = m_rotation.array();
+  return Vector(r[0]*x + r[4]*y + r[8]*z  + m_translation.x(),
+                r[1]*x + r[5]*y + r[9]*z  + m_translation.y(),
+                r[2]*x + r[6]*y + r[10]*z + m_translation.z());
+}
+
 // -------------------------------------------------------------------------
 // clear() : clear the object's transforms
 // -------------------------------------------------------------------------
@@ -104,6 +136,11 @@ void Transform::setRotation(double degrees, const Vector& v)
   addRotation(degrees, v);
 }
 
+void Transform::setRotation(const Matrix& m)
+{
+  m_rotation = m;
+}
+
 bool Transform::addRotation(double degrees, const Vector& v)
 {
   Vector nv = v; // will hold normalized 'v' vector
@@ -33,10 +33,15 @@ class Transform
 {
  public:
   Transform();
+  Transform(const Transform& t);
+  ~Transform();
 
   // apply opengl transformations
   void apply() const;
 
+  // the same transformations, applied to a point
+  Vector applyTo(const Vector& i_point) const;
+
   // clear the object's transforms
   void clear();
   void clearTranslation();
@@ -52,6 +57,7 @@ class Transform
   void addTranslation(const Vector& v);
 
   void setRotation(double degrees, const Vector& v);
+  void setRotation(const Matrix& m);
   bool addRotation(double degrees, const Vector& v);
 
   void setScaling(const Vector& v);
@@ -0,0 +1,397 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "worldpager.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// -------------------------------------------------------------------------
+// WorldPager::Io : background thread, runs the file requests in order
+// -------------------------------------------------------------------------
+
+class WorldPager::Io : public QThread
+{
+ public:
+  Io(WorldPager* i_pager)
+    :QThread(), mp_pager(i_pager) {}
+
+ protected:
+  virtual void run();
+
+ private:
+  WorldPager* mp_pager;
+};
+
+void WorldPager::Io::run()
+{
+  WorldPager* p = mp_pager;
+  QMutexLocker lock(&p->m_mutex);
+  for (;;) {
+    if (p->m_requests.empty()) {
+      p->m_busy = false;
+      p->m_done.wakeAll();
+      if (p->m_quit) return;
+      p->m_work.wait(&p->m_mutex);
+      continue;
+    }
+
+    Request request;
+    request.type = p->m_requests.front().type;
+    request.cell = p->m_requests.front().cell;
+    request.bodies.swap(p->m_requests.front().bodies);
+    p->m_requests.pop_front();
+    p->m_busy = true;
+
+    lock.unlock();
+    p->run(request);
+    lock.relock();
+  }
+}
+
+bool WorldPager::Cell::operator<(const Cell& c) const
+{
+  return ((x < c.x) || ((x == c.x) && (z < c.z)));
+}
+
+bool WorldPager::Cell::operator==(const Cell& c) const
+{
+  return ((x == c.x) && (z == c.z));
+}
+
+static bool lessCell(const WorldPager::Body& a, const WorldPager::Body& b)
+{
+  return (a.cell < b.cell);
+}
+
+WorldPager::WorldPager()
+  :m_size(0.),
+   m_radius(0.),
+   m_focused(false),
+   m_focus(),
+   m_loaded(),
+   m_stored(),
+   m_directory(),
+   mp_io(0),
+   m_mutex(),
+   m_work(),
+   m_done(),
+   m_requests(),
+   m_busy(false),
+   m_quit(false),
+   m_read()
+{
+  m_focus.x = m_focus.z = 0;
+}
+
+WorldPager::~WorldPager()
+{
+  // the files go away with the world
+  clear();
+  if (mp_io) {
+    {
+      QMutexLocker lock(&m_mutex);
+      m_quit = true;
+      m_work.wakeAll();
+    }
+    mp_io->wait();
+    delete mp_io; mp_io = 0;
+  }
+  if (!m_directory.isEmpty()) QDir().rmdir(m_directory);
+}
+
+// -------------------------------------------------------------------------
+// setCellSize(size), setRadius(radius) : how the world is paged
+//
+// notes : changing the size of the cells forgets the world stored so far
+// -------------------------------------------------------------------------
+
+void WorldPager::setCellSize(double i_size)
+{
+  if (i_size < 0.) i_size = 0.;
+  if (i_size == m_size) return;
+  clear();
+  m_size = i_size;
+}
+
+double WorldPager::cellSize() const
+{
+  return m_size;
+}
+
+void WorldPager::setRadius(double i_radius)
+{
+  m_radius  = i_radius;
+  m_focused = false;
+}
+
+bool WorldPager::enabled() const
+{
+  return (m_size > 0.);
+}
+
+// -------------------------------------------------------------------------
+// cell(point), corner(cell), center(cell), loaded(cell) : cells of the
+//                                                       floor
+//
+// notes : without paging, there is a single cell, always loaded
+// -------------------------------------------------------------------------
+
+WorldPager::Cell WorldPager::cell(const Vector& i_point) const
+{
+  Cell res;
+  res.x = res.z = 0;
+  if (enabled()) {
+    res.x = (qint32)floor(i_point.x() / m_size);
+    res.z = (qint32)floor(i_point.z() / m_size);
+  }
+  return res;
+}
+
+Vector WorldPager::corner(const Cell& i_cell) const
+{
+  return Vector(i_cell.x * m_size, 0., i_cell.z * m_size);
+}
+
+Vector WorldPager::center(const Cell& i_cell) const
+{
+  return Vector((i_cell.x + 0.5) * m_size, 0., (i_cell.z + 0.5) * m_size);
+}
+
+bool WorldPager::loaded(const Cell& i_cell) const
+{
+  return (!enabled() || (m_loaded.find(i_cell) != m_loaded.end()));
+}
+
+// -------------------------------------------------------------------------
+// setFocus(focus) : load the cells around the focus, unload the ones too
+//                   far away
+//
+// notes : the cells within the radius (along x or z) are loaded, they are
+//         unloaded one cell farther. nothing happens while the focus
+//         stays in the same cell.
+// -------------------------------------------------------------------------
+
+void WorldPager::setFocus(const Vector& i_focus)
+{
+  if (!enabled()) return;
+  Cell focus = cell(i_focus);
+  if (m_focused && (focus == m_focus)) return;
+  m_focused = true;
+  m_focus   = focus;
+
+  int reach = (int)ceil(m_radius / m_size);
+  if (reach < 0) reach = 0;
+
+  for (set_cells::iterator it = m_loaded.begin(); it != m_loaded.end(); ) {
+    if ((abs((*it).x - focus.x) > reach + 1) ||
+        (abs((*it).z - focus.z) > reach + 1))
+      m_loaded.erase(it++);
+    else
+      it++;
+  }
+
+  for (qint32 x = focus.x - reach; x <= focus.x + reach; x++)
+    for (qint32 z = focus.z - reach; z <= focus.z + reach; z++) {
+      Cell c;
+      c.x = x; c.z = z;
+      if (!m_loaded.insert(c).second) continue;
+
+      map_cells::iterator s = m_stored.find(c);
+      if (s == m_stored.end()) continue;
+      m_stored.erase(s);
+      queue(LOAD, c);
+    }
+}
+
+// -------------------------------------------------------------------------
+// store(bodies) : add bodies to the files of their cells
+// take(bodies)  : collect the bodies read back
+// -------------------------------------------------------------------------
+
+void WorldPager::store(const vec_bodies& i_bodies)
+{
+  if (!enabled() || i_bodies.empty()) return;
+
+  // one request for each cell
+  vec_bodies sorted(i_bodies);
+  std::stable_sort(sorted.begin(), sorted.end(), lessCell);
+  unsigned int first = 0;
+  while (first < sorted.size()) {
+    unsigned int last = first + 1;
+    while ((last < sorted.size()) &&
+           (sorted[last].cell == sorted[first].cell))
+      last++;
+
+    vec_bodies cell(sorted.begin() + first, sorted.begin() + last);
+    m_stored[cell[0].cell] += cell.size();
+    queue(STORE, cell[0].cell, &cell);
+    first = last;
+  }
+}
+
+int WorldPager::take(vec_bodies& o_bodies)
+{
+  QMutexLocker lock(&m_mutex);
+  int count = m_read.size();
+  o_bodies.insert(o_bodies.end(), m_read.begin(), m_read.end());
+  m_read.clear();
+  return count;
+}
+
+// -------------------------------------------------------------------------
+// flush() : wait until the background thread is done
+// -------------------------------------------------------------------------
+
+void WorldPager::flush()
+{
+  QMutexLocker lock(&m_mutex);
+  while (!m_requests.empty() || m_busy)
+    m_done.wait(&m_mutex);
+}
+
+// -------------------------------------------------------------------------
+// clear() : forget the cells stored and loaded
+//
+// notes : the files being read are removed by the reads themselves
+// -------------------------------------------------------------------------
+
+void WorldPager::clear()
+{
+  for (map_cells::const_iterator it = m_stored.begin();
+       it != m_stored.end(); it++)
+    queue(REMOVE, (*it).first);
+  m_stored.clear();
+  m_loaded.clear();
+  m_focused = false;
+
+  flush();
+  QMutexLocker lock(&m_mutex);
+  m_read.clear();
+}
+
+int WorldPager::storedCells() const
+{
+  return m_stored.size();
+}
+
+int WorldPager::storedBodies() const
+{
+  int res = 0;
+  for (map_cells::const_iterator it = m_stored.begin();
+       it != m_stored.end(); it++)
+    res += (*it).second;
+  return res;
+}
+
+// -------------------------------------------------------------------------
+// queue(type, cell, bodies) : hand a request to the background thread
+//
+// notes : the thread and the directory of the files are only created
+//         once the world is paged for the first time
+// -------------------------------------------------------------------------
+
+void WorldPager::queue(RequestType i_type, const Cell& i_cell,
+                       const vec_bodies* i_bodies)
+{
+  if (m_directory.isEmpty()) {
+    m_directory = QDir(QDir::tempPath()).filePath
+      (QString("shaolin_sheep_%1_%2")
+       .arg((qint64)QCoreApplication::applicationPid())
+       .arg((qint64)(quintptr)this));
+    if (!QDir().mkpath(m_directory))
+      qWarning("pager : cannot create %s",
+               m_directory.toLocal8Bit().constData());
+  }
+  if (!mp_io) {
+    mp_io = new Io(this);
+    mp_io->start();
+  }
+
+  QMutexLocker lock(&m_mutex);
+  m_requests.push_back(Request());
+  Request& request = m_requests.back();
+  request.type = i_type;
+  request.cell = i_cell;
+  if (i_bodies) request.bodies = *i_bodies;
+  m_work.wakeOne();
+}
+
+// -------------------------------------------------------------------------
+// run(request) : write, read or remove the file of a cell (on the
+//                background thread)
+//
+// notes : the bodies are written as they are in memory, the files only
+//         live as long as the pager
+// -------------------------------------------------------------------------
+
+void WorldPager::run(Request& io_request)
+{
+  QString name = file(io_request.cell);
+  vec_bodies& bodies = io_request.bodies;
+
+  switch (io_request.type) {
+  case STORE:
+    {
+      QFile f(name);
+      qint64 bytes = bodies.size() * sizeof(Body);
+      if (!f.open(QIODevice::WriteOnly | QIODevice::Append) ||
+          (f.write((const char*)&bodies[0], bytes) != bytes))
+        qWarning("pager : cannot write %s, %d bodies lost",
+                 name.toLocal8Bit().constData(), (int)bodies.size());
+    }
+    break;
+
+  case LOAD:
+    {
+      QFile f(name);
+      if (f.open(QIODevice::ReadOnly)) {
+        bodies.resize(f.size() / sizeof(Body));
+        qint64 bytes = bodies.size() * sizeof(Body);
+        if (!bodies.empty() && (f.read((char*)&bodies[0], bytes) != bytes))
+          bodies.clear();
+      }
+      if (bodies.empty())
+        qWarning("pager : cannot read %s",
+                 name.toLocal8Bit().constData());
+      f.close();
+      QFile::remove(name);
+
+      QMutexLocker lock(&m_mutex);
+      m_read.insert(m_read.end(), bodies.begin(), bodies.end());
+    }
+    break;
+
+  case REMOVE:
+    QFile::remove(name);
+    break;
+  }
+}
+
+QString WorldPager::file(const Cell& i_cell) const
+{
+  return QDir(m_directory).filePath(QString("cell_%1_%2")
+                                    .arg(i_cell.x).arg(i_cell.z));
+}
@@ -0,0 +1,164 @@
+/*
+    Shaolin Sheep - OpenGL/Qt Demo
+    Copyright (c) 2006  Sylvain Bernier <sylvain.bernier@gmail.com>
+
+    This file is part of Shaolin Sheep.
+
+    Shaolin Sheep is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Shaolin Sheep is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Shaolin Sheep; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef WORLDPAGER_H
+#define WORLDPAGER_H
+class   WorldPager;
+
+#include "vector.h"
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+class WorldPager
+//
+// WorldPager : the floor of the world cut in square cells, only the cells
+//              around a focus point are kept in memory
+//
+//   - the cells within a radius of the focus are loaded, they are only
+//     unloaded once more than a cell beyond it (a focus going back and
+//     forth over a cell border does not page the same cells each time)
+//   - the bodies in the cells that are not loaded are stored on disk, one
+//     file per cell, and stay frozen there. a file is read back, and
+//     removed, when its cell is loaded again
+//   - the files are written and read in order by a background thread :
+//     the owner only queues the bodies to store, and takes the bodies
+//     read back once they are there
+//
+{
+ public:
+  struct Cell
+  //
+  // Cell : a square of the floor, [x, x + 1[ * [z, z + 1[ cell sizes
+  //
+  {
+    qint32 x, z;
+    bool operator<(const Cell& c) const;
+    bool operator==(const Cell& c) const;
+  };
+
+  struct Body
+  //
+  // Body : what is kept of a body while its cell is not loaded (floats,
+  //        the position from the corner of the cell stays precise)
+  //
+  {
+    Cell   cell;          // where the body is
+    float  position[3];   // from the corner of the cell (see corner)
+    float  velocity[3];
+    float  rotation[9];   // 3x3, column major
+    float  scaling[3];
+    float  size;          // sheep size, ball radius
+    float  phase;         // sheep animation (see Sheep::setAnimationState)
+    float  orientation;
+    qint32 kind;          // Snapshot::BodyKind
+    qint32 flags;         // Snapshot::BodyFlags
+    qint32 victim;        // 1 -> one of the sheep to protect
+    qint32 texture;       // in the scene textures (-1 -> none)
+  };
+  typedef std::vector<Body> vec_bodies;
+
+  WorldPager();
+  ~WorldPager();
+
+  // size of the cells (m, 0 -> no paging), and how far from the focus
+  // the cells are loaded (m)
+  void   setCellSize(double i_size);
+  double cellSize() const;
+  void   setRadius(double i_radius);
+  bool   enabled() const;
+
+  // the cell a point of the floor is in, its corner (smallest x, z) and
+  // its center
+  Cell   cell(const Vector& i_point) const;
+  Vector corner(const Cell& i_cell) const;
+  Vector center(const Cell& i_cell) const;
+
+  // is the cell loaded? (bodies in the other cells must be stored)
+  bool loaded(const Cell& i_cell) const;
+
+  // move the focus : the cells around it are loaded (their files are
+  // read back), the cells too far away are unloaded
+  void setFocus(const Vector& i_focus);
+
+  // store bodies in cells that are not loaded (added to their files)
+  void store(const vec_bodies& i_bodies);
+
+  // bodies read back since the last call, appended to 'bodies'
+  int take(vec_bodies& o_bodies);
+
+  // wait until the files are written and read
+  void flush();
+
+  // forget the whole world : the files are removed, no cell is loaded
+  void clear();
+
+  // cells and bodies stored on disk (or about to be)
+  int storedCells() const;
+  int storedBodies() const;
+
+ private:
+  enum RequestType { STORE, LOAD, REMOVE };
+
+  struct Request
+  //
+  // Request : file operation, for the background thread
+  //
+  {
+    RequestType type;
+    Cell        cell;
+    vec_bodies  bodies;  // STORE only
+  };
+  typedef std::deque<Request>  deq_requests;
+  typedef std::set<Cell>       set_cells;
+  typedef std::map<Cell, int>  map_cells;
+
+  class Io;
+  friend class Io;
+
+  void    queue(RequestType i_type, const Cell& i_cell,
+                const vec_bodies* i_bodies = 0);
+  void    run(Request& io_request);
+  QString file(const Cell& i_cell) const;
+
+  double       m_size;       // of a cell (m), 0 -> no paging
+  double       m_radius;     // cells loaded around the focus (m)
+  bool         m_focused;    // has the focus been set since clear()?
+  Cell         m_focus;      // cell of the focus
+  set_cells    m_loaded;     // loaded cells
+  map_cells    m_stored;     // bodies stored on disk, by cell
+  QString      m_directory;  // where the cell files are ("" -> not yet)
+
+  Io*          mp_io;        // background thread (0 -> not started yet)
+  QMutex       m_mutex;      // protects what follows
+  QWaitCondition m_work;     // signaled when a request is queued
+  QWaitCondition m_done;     // signaled when the requests are all done
+  deq_requests m_requests;   // waiting for the background thread
+  bool         m_busy;       // a request is being run
+  bool         m_quit;       // the background thread should stop
+  vec_bodies   m_read;       // bodies read back, not taken yet
+};
+
+#endif // WORLDPAGER_H